@@ -0,0 +1,105 @@
+import os
+import mmap
+import struct
+import time
+import argparse
+
+"""Binary DDM header layout (see include/DD_Binary.h)"""
+DDM_HEADER = struct.Struct("<4s7I6Q")
+"""Binary DDM ebo table entry"""
+DDM_EBO = struct.Struct("<IIQ")
+"""Binary DDM vertex flags"""
+DDM_FLAG_JOINT8 = 0x1
+DDM_FLAG_WEIGHT8 = 0x2
+DDM_FLAG_WEIGHT16 = 0x4
+
+def vert_stride(flags):
+    """Bytes per DDMVertexT: 44 bytes of floats, 4 joints and 4 weights"""
+    joint = 1 if flags & DDM_FLAG_JOINT8 else 2
+    weight = 1 if flags & DDM_FLAG_WEIGHT8 else \
+        2 if flags & DDM_FLAG_WEIGHT16 else 4
+    return 44 + 4 * joint + 4 * weight
+
+def load_text_ddm(ddm_file):
+    """Parses a text DDM the way the engine does and returns the number of
+    vertices and indices read"""
+    verts = []
+    indices = []
+    section = None
+    with open(ddm_file, 'r') as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith("</"):
+                section = None
+                continue
+            if line.startswith("<"):
+                section = line[1:-1]
+                continue
+            data = line.split()
+            if section == "vertex":
+                verts += [[float(s) for s in data[1:]]]
+            elif section == "ebo" and data[0] == "-":
+                indices += [int(s) for s in data[1:]]
+    return (len(verts) // 6, len(indices))
+
+def load_binary_ddm(ddmb_file):
+    """Maps a binary DDM and returns views over the vertex and index blobs"""
+    with open(ddmb_file, 'rb') as f:
+        buff = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+    (magic, version, stride, num_verts, num_ebos, num_mats, flags, num_shapes,
+     name_off, mat_off, vert_off, ebo_off, shape_off,
+     reserved) = DDM_HEADER.unpack_from(buff, 0)
+    if magic != b"DDMB" or stride != vert_stride(flags):
+        raise ValueError("%s is not a v%d binary DDM" % (ddmb_file, version))
+    view = memoryview(buff)
+    verts = view[vert_off:vert_off + num_verts * stride]
+    num_indices = 0
+    for i in range(num_ebos):
+        mat_idx, count, offset = DDM_EBO.unpack_from(buff,
+                                                     ebo_off + i * DDM_EBO.size)
+        ebo = view[offset:offset + count * 4]
+        indices = ebo.cast("I")
+        num_indices += len(indices)
+        indices.release()
+        ebo.release()
+    num_verts = len(verts) // stride
+    verts.release()
+    view.release()
+    buff.close()
+    return (num_verts, num_indices)
+
+def time_load(loader, path, runs):
+    """Returns the best load time (ms) over runs and the loader output"""
+    best = None
+    out = None
+    for i in range(runs):
+        start = time.perf_counter()
+        out = loader(path)
+        elapsed = (time.perf_counter() - start) * 1000.0
+        best = elapsed if best is None else min(best, elapsed)
+    return (best, out)
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compare size and load time of text vs binary DDM files "
+                    "(export each mesh with Fbx_Parser -mM first)")
+    parser.add_argument("ddm", nargs="+", help="text .ddm files (the matching "
+                        ".ddmb must sit next to each one)")
+    parser.add_argument("-r", "--runs", type=int, default=5,
+                        help="number of timed loads per file")
+    args = parser.parse_args()
+
+    print("%-32s %12s %12s %10s %10s %8s" %
+          ("mesh", "text(B)", "binary(B)", "text(ms)", "bin(ms)", "speedup"))
+    for ddm in args.ddm:
+        ddmb = os.path.splitext(ddm)[0] + ".ddmb"
+        t_ms, t_out = time_load(load_text_ddm, ddm, args.runs)
+        b_ms, b_out = time_load(load_binary_ddm, ddmb, args.runs)
+        if t_out != b_out:
+            print("%s: mismatch text %s vs binary %s" % (ddm, t_out, b_out))
+        print("%-32s %12d %12d %10.3f %10.3f %7.1fx" %
+              (os.path.basename(ddm), os.path.getsize(ddm),
+               os.path.getsize(ddmb), t_ms, b_ms, t_ms / max(b_ms, 1e-6)))
+
+if __name__ == "__main__":
+    main()
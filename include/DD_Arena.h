@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <algorithm>
+#include <DD_Container.h>
+
+/*-----------------------------------------------------------------------------
+*
+*	dd_arena:
+*		- linear (bump) allocator for short-lived scratch memory
+*			- allocations are not freed one by one, except at the top of the
+*			  arena (LIFO frees roll the bump pointer back)
+*			- reset() drops everything at once and keeps one block big enough
+*			  for the last run (up to DD_ARENA_MAX_RETAIN, so idle workers
+*			  stay small), so repeated runs stop hitting the heap
+*		- not thread safe: one arena per thread
+*	dd_arena_scope:
+*		- installs an arena as the current thread's scratch arena
+*	dd_scratch_alloc:
+*		- dd_array storage policy drawing from the current scratch arena
+*			- falls back to the heap when no arena is installed
+*
+-----------------------------------------------------------------------------*/
+
+#define DD_ARENA_BLOCK_SIZE (4 << 20)
+#define DD_ARENA_MAX_RETAIN ((size_t)32 << 20)	// largest block kept by reset
+
+class dd_arena
+{
+public:
+	dd_arena(const size_t block_size = DD_ARENA_BLOCK_SIZE) :
+		m_blocks(nullptr),
+		m_blockSize(block_size),
+		m_used(0),
+		m_peak(0)
+	{}
+	~dd_arena()
+	{
+		release();
+	}
+
+	/// \brief Bump allocate bytes (align must be a power of 2)
+	void* allocate(const size_t bytes, const size_t align)
+	{
+		if( !m_blocks || !fits(m_blocks, bytes, align) ) {
+			addBlock(bytes + align);
+		}
+		Block* block = m_blocks;
+		const uintptr_t base = (uintptr_t)block->data() + block->used;
+		const uintptr_t aligned = (base + align - 1) & ~(uintptr_t)(align - 1);
+		block->used = (size_t)(aligned - (uintptr_t)block->data()) + bytes;
+		m_used += (size_t)(aligned - base) + bytes;
+		m_peak = std::max(m_peak, m_used);
+		return (void*)aligned;
+	}
+
+	/// \brief Give memory back. Only an allocation at the top of the newest
+	/// block is reclaimed (scoped scratch freed in reverse order), everything
+	/// else waits for reset()
+	void deallocate(void* ptr, const size_t bytes)
+	{
+		Block* block = m_blocks;
+		if( block && (char*)ptr + bytes == block->data() + block->used ) {
+			const size_t offset = (size_t)((char*)ptr - block->data());
+			m_used -= block->used - offset;
+			block->used = offset;
+		}
+	}
+
+	/// \brief True if ptr was handed out by this arena
+	bool owns(const void* ptr) const
+	{
+		for( Block* block = m_blocks; block; block = block->next ) {
+			if( (const char*)ptr >= block->data() &&
+				(const char*)ptr < block->data() + block->size ) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// \brief Drop every allocation. The blocks are merged into one block
+	/// sized for the whole run (up to DD_ARENA_MAX_RETAIN) for the next run
+	void reset()
+	{
+		size_t total = 0;
+		for( Block* block = m_blocks; block; block = block->next ) {
+			total += block->size;
+		}
+		if( m_blocks && m_blocks->next ) {
+			release();
+			addBlock(std::min(total, DD_ARENA_MAX_RETAIN));
+		}
+		else if( m_blocks && total > DD_ARENA_MAX_RETAIN ) {
+			release();
+		}
+		if( m_blocks ) {
+			m_blocks->used = 0;
+		}
+		m_used = 0;
+		m_peak = 0;
+	}
+
+	/// \brief Bytes in use (including alignment padding)
+	inline size_t bytesUsed() const { return m_used; }
+	/// \brief Most bytes in use since the last reset
+	inline size_t bytesPeak() const { return m_peak; }
+
+	/// \brief Scratch arena of the calling thread (nullptr if none)
+	static dd_arena*& current()
+	{
+		static thread_local dd_arena* arena = nullptr;
+		return arena;
+	}
+
+private:
+	struct Block
+	{
+		Block*	next;
+		size_t	size;
+		size_t	used;
+		inline char* data() const { return (char*)(this + 1); }
+	};
+
+	bool fits(const Block* block, const size_t bytes, const size_t align) const
+	{
+		const uintptr_t base = (uintptr_t)block->data() + block->used;
+		const uintptr_t aligned = (base + align - 1) & ~(uintptr_t)(align - 1);
+		return aligned + bytes <= (uintptr_t)block->data() + block->size;
+	}
+	void addBlock(const size_t min_size)
+	{
+		const size_t size = std::max(min_size, m_blockSize);
+		Block* block = (Block*)::operator new(sizeof(Block) + size);
+		block->next = m_blocks;
+		block->size = size;
+		block->used = 0;
+		m_blocks = block;
+	}
+	void release()
+	{
+		while( m_blocks ) {
+			Block* next = m_blocks->next;
+			::operator delete(m_blocks);
+			m_blocks = next;
+		}
+	}
+
+	Block*	m_blocks;		// newest block first
+	size_t	m_blockSize;
+	size_t	m_used;
+	size_t	m_peak;
+
+	dd_arena(const dd_arena&);
+	dd_arena& operator=(const dd_arena&);
+};
+
+/// \brief Make arena the calling thread's scratch arena while in scope
+struct dd_arena_scope
+{
+	dd_arena_scope(dd_arena& arena) : m_prev(dd_arena::current())
+	{
+		dd_arena::current() = &arena;
+	}
+	~dd_arena_scope()
+	{
+		dd_arena::current() = m_prev;
+	}
+
+	dd_arena* m_prev;
+};
+
+/// \brief dd_array storage from the current scratch arena (arrays must not
+/// outlive the arena's next reset). Arrays must also be freed while the arena
+/// they came from is current: with another arena (or none) installed the
+/// pointer is not recognized and goes to ::operator delete, which is
+/// undefined for arena memory
+struct dd_scratch_alloc
+{
+	static void* allocate(const size_t bytes, const size_t align)
+	{
+		dd_arena* arena = dd_arena::current();
+		return arena ? arena->allocate(bytes, align) : ::operator new(bytes);
+	}
+	static void deallocate(void* ptr, const size_t bytes)
+	{
+		dd_arena* arena = dd_arena::current();
+		if( arena && arena->owns(ptr) ) {
+			arena->deallocate(ptr, bytes);
+		}
+		else {
+			::operator delete(ptr);
+		}
+	}
+};
+
+/// \brief dd_array drawing from the current scratch arena
+template <class T>
+using dd_scratch_array = dd_array<T, dd_scratch_alloc>;
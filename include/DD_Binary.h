@@ -0,0 +1,299 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/*
+* Copyright (c) 2017, Moses Adeagbo
+* All rights reserved.
+*/
+
+/*-----------------------------------------------------------------------------
+*
+*	Binary Day Dream asset layouts (see dd_entity_map.txt):
+*		- little-endian, written straight from memory
+*		- every section offset is from the start of the file and is aligned
+*		  to DD_BIN_ALIGN so a loader can mmap the file and hand the vertex /
+*		  index blobs to the GPU without copying or parsing
+*		- header version is bumped whenever a layout below changes
+*
+-----------------------------------------------------------------------------*/
+
+#define DD_BIN_ALIGN 16
+#define DDM_BIN_VERSION 4
+#define DDA_BIN_VERSION 4
+#define DDB_BIN_VERSION 1
+
+// DDMHeader flags
+#define DDM_FLAG_JOINT8 0x1	// 8-bit joint indices (every joint index < 256)
+#define DDM_FLAG_WEIGHT8 0x2	// 8-bit unorm skin weights
+#define DDM_FLAG_WEIGHT16 0x4	// 16-bit unorm skin weights
+
+// DDAHeader flags
+#define DDA_FLAG_KEYED 0x1	// tracks hold reduced keys w/ explicit frames
+#define DDA_FLAG_QUANTIZED 0x2	// tracks hold fixed point keys (see DDAQuantRange)
+
+/// \brief Round offset up to the next DD_BIN_ALIGN boundary
+inline uint64_t ddBinAlign(const uint64_t offset)
+{
+	return (offset + (DD_BIN_ALIGN - 1)) & ~(uint64_t)(DD_BIN_ALIGN - 1);
+}
+
+/// \brief DDM file header (80 bytes)
+struct DDMHeader
+{
+	char		magic[4];		// "DDMB"
+	uint32_t	version;		// DDM_BIN_VERSION
+	uint32_t	vert_stride;	// sizeof(DDMVertexT<joint, weight>)
+	uint32_t	num_verts;
+	uint32_t	num_ebos;
+	uint32_t	num_mats;
+	uint32_t	flags;			// DDM_FLAG_*
+	uint32_t	num_shapes;
+	uint64_t	name_offset;	// uint32_t length followed by chars
+	uint64_t	mat_offset;		// num_mats * DDMMaterial
+	uint64_t	vert_offset;	// num_verts * vert_stride
+	uint64_t	ebo_offset;		// num_ebos * DDMEbo
+	uint64_t	shape_offset;	// num_shapes * DDMShape (0 when no shapes)
+	uint64_t	reserved;
+};
+
+/// \brief Material record (fixed size so the table can be indexed directly)
+struct DDMMaterial
+{
+	char		id[64];
+	char		diffmap[128];
+	char		normmap[128];
+	char		specmap[128];
+	char		roughmap[128];
+	char		metalmap[128];
+	char		emitmap[128];
+	char		aomap[128];
+	float		ambient[3];
+	float		diffuse[3];
+	float		specular[3];
+	float		emissive[3];
+	float		transfactor;
+	float		reflectfactor;
+	float		specfactor;
+	uint32_t	textypes;		// MatType bit flags
+};
+
+/// \brief Tightly packed vertex (matches the text DDM vertex fields)
+/// \param J joint index type: uint16_t or uint8_t (DDM_FLAG_JOINT8)
+/// \param W skin weight type: float, uint8_t (DDM_FLAG_WEIGHT8) or uint16_t
+/// (DDM_FLAG_WEIGHT16), unorm weights of a vertex sum to exactly 255 / 65535
+template <typename J, typename W>
+struct DDMVertexT
+{
+	float		pos[3];
+	float		norm[3];
+	float		tang[3];
+	float		uv[2];
+	J			joint[4];
+	W			blend[4];
+};
+
+/// \brief Record size of a vertex w/ joint index type J and weight_bits (0:
+/// float, 8 or 16: unorm)
+template <typename J>
+inline uint32_t ddmVertStride(const uint32_t weight_bits)
+{
+	return (weight_bits == 8) ? sizeof(DDMVertexT<J, uint8_t>) :
+		(weight_bits == 16) ? sizeof(DDMVertexT<J, uint16_t>) :
+		sizeof(DDMVertexT<J, float>);
+}
+
+/// \brief 16-bit joint indices, float weights (68 bytes)
+typedef DDMVertexT<uint16_t, float> DDMVertex;
+/// \brief Compact vertex written when the rig fits in 8-bit joint indices
+/// (DDM_FLAG_JOINT8, 64 bytes)
+typedef DDMVertexT<uint8_t, float> DDMVertex8;
+
+/// \brief EBO table entry. Indices are uint32_t triangles lists starting at
+/// offset (num_indices is a multiple of 3)
+struct DDMEbo
+{
+	uint32_t	mat_idx;
+	uint32_t	num_indices;
+	uint64_t	offset;
+};
+
+/// \brief DDB file header (80 bytes). Joints are stored in topological order
+/// (a parent always precedes its children, roots are their own parent)
+struct DDBHeader
+{
+	char		magic[4];		// "DDBB"
+	uint32_t	version;		// DDB_BIN_VERSION
+	uint32_t	num_joints;
+	uint32_t	flags;			// reserved (0)
+	float		wspos[3];		// joint to world space
+	float		wsrot[3];
+	float		wsscl[3];
+	uint32_t	pad;
+	uint64_t	joint_offset;	// num_joints * DDBJoint
+	uint64_t	bind_offset;	// num_joints * DDBInvBind
+	uint64_t	reserved;
+};
+
+/// \brief Joint record (same fields as the text DDB joint)
+struct DDBJoint
+{
+	char		name[32];
+	uint32_t	idx;
+	uint32_t	parent;
+	float		pos[3];
+	float		rot[3];
+	float		scl[3];
+	uint32_t	pad;
+};
+
+/// \brief Inverse bind matrix (mesh space -> joint space at bind time) as the
+/// top 3 rows of a row-major 4x4 (column vectors, translation in m[3], m[7],
+/// m[11]). Records are 16-byte aligned so they load straight into SIMD
+/// registers: palette[j] = world[j] * inv_bind[j]
+struct DDBInvBind
+{
+	float		m[12];
+};
+
+/// \brief Blend shape table entry. The blob at offset holds num_deltas
+/// (32-bit uint) ascending vertex indices (padded to DD_BIN_ALIGN) followed
+/// by num_deltas DDMShapeDelta records
+struct DDMShape
+{
+	char		id[64];
+	uint32_t	num_deltas;
+	uint32_t	pad;
+	uint64_t	offset;
+};
+
+/// \brief Sparse blend shape delta (added to the vertex at full weight)
+struct DDMShapeDelta
+{
+	float		pos[3];
+	float		norm[3];
+};
+
+/// \brief Byte offset of a blend shape's DDMShapeDelta records
+inline uint64_t ddmShapeDeltaOffset(const DDMShape &shape)
+{
+	return shape.offset +
+		ddBinAlign((uint64_t)shape.num_deltas * sizeof(uint32_t));
+}
+
+/// \brief DDA file header (64 bytes)
+struct DDAHeader
+{
+	char		magic[4];		// "DDAB"
+	uint32_t	version;		// DDA_BIN_VERSION
+	uint32_t	num_joints;
+	uint32_t	num_frames;
+	float		framerate;
+	uint32_t	repeat;			// 0 or 1
+	uint32_t	flags;			// DDA_FLAG_*
+	uint32_t	quant_bits;		// fixed point bits (DDA_FLAG_QUANTIZED only)
+	uint64_t	joint_offset;	// num_joints * DDAJoint
+	uint64_t	shape_offset;	// num_shapes * DDAShape (0 when no shapes)
+	uint32_t	num_shapes;		// blend shape weight tracks
+	uint32_t	pad;
+	uint64_t	reserved;
+};
+
+/// \brief Joint track table entry. Each track block holds num_keys floats per
+/// channel laid out as planes: rot x, rot y, rot z, pos x, pos y, pos z. With
+/// DDA_FLAG_KEYED the planes are preceded by num_keys (32-bit uint) key frames
+/// (padded to DD_BIN_ALIGN), otherwise num_keys == num_frames
+struct DDAJoint
+{
+	uint32_t	joint_idx;
+	uint32_t	num_keys;
+	uint64_t	offset;
+};
+
+/// \brief Blend shape weight track: num_frames floats (0-1, one per frame) at
+/// offset. Matched to DDMShape records by id
+struct DDAShape
+{
+	char		id[64];
+	uint64_t	offset;
+	uint64_t	pad;
+};
+
+/// \brief Per-track ranges of a quantized joint block. A stored value q
+/// decodes to min + extent * q / ((1 << quant_bits) - 1). Rotations are
+/// smallest-three quaternions: the three components left after dropping the
+/// largest (which is positive and rebuilt as sqrt(1 - a^2 - b^2 - c^2))
+struct DDAQuantRange
+{
+	float		rot_min[3];
+	float		rot_extent[3];
+	float		pos_min[3];
+	float		pos_extent[3];
+};
+
+/// \brief Byte size of one fixed point value (8 or 16-bit containers)
+inline uint64_t ddaQuantElemSize(const DDAHeader &header)
+{
+	return (header.quant_bits <= 8) ? 1 : 2;
+}
+
+/// \brief Byte size of a joint's key frame list (0 when not keyed)
+inline uint64_t ddaKeyBlockSize(const DDAHeader &header, const DDAJoint &joint)
+{
+	return (header.flags & DDA_FLAG_KEYED) ?
+		ddBinAlign((uint64_t)joint.num_keys * sizeof(uint32_t)) : 0;
+}
+
+/// \brief Byte offset of a quantized joint's DDAQuantRange
+inline uint64_t ddaQuantRangeOffset(const DDAHeader &header,
+									const DDAJoint &joint)
+{
+	return joint.offset + ddaKeyBlockSize(header, joint);
+}
+
+/// \brief Byte offset of a quantized joint's dropped component list
+/// (8-bit uint per key: 0-3 for quaternion x, y, z, w)
+inline uint64_t ddaQuantLargestOffset(const DDAHeader &header,
+									  const DDAJoint &joint)
+{
+	return ddaQuantRangeOffset(header, joint) + sizeof(DDAQuantRange);
+}
+
+/// \brief Byte offset of channel plane (0-5) inside a joint track block
+inline uint64_t ddaChannelOffset(const DDAHeader &header,
+								 const DDAJoint &joint,
+								 const uint32_t channel)
+{
+	if (header.flags & DDA_FLAG_QUANTIZED) {
+		return ddaQuantLargestOffset(header, joint) + ddBinAlign(joint.num_keys) +
+			(uint64_t)channel * joint.num_keys * ddaQuantElemSize(header);
+	}
+	return joint.offset + ddaKeyBlockSize(header, joint) +
+		(uint64_t)channel * joint.num_keys * sizeof(float);
+}
+
+/// \brief Byte size of a joint's track block (padded to DD_BIN_ALIGN)
+inline uint64_t ddaTrackBlockSize(const DDAHeader &header, const DDAJoint &joint)
+{
+	return ddBinAlign(ddaChannelOffset(header, joint, 6) - joint.offset);
+}
+
+static_assert(sizeof(DDMHeader) == 80, "DDMHeader layout changed");
+static_assert(sizeof(DDMMaterial) == 1024, "DDMMaterial layout changed");
+static_assert(sizeof(DDMVertex) == 68, "DDMVertex layout changed");
+static_assert(sizeof(DDMVertex8) == 64, "DDMVertex8 layout changed");
+static_assert(sizeof(DDMVertexT<uint16_t, uint16_t>) == 60,
+			  "DDMVertexT layout changed");
+static_assert(sizeof(DDMVertexT<uint8_t, uint8_t>) == 52,
+			  "DDMVertexT layout changed");
+static_assert(sizeof(DDMEbo) == 16, "DDMEbo layout changed");
+static_assert(sizeof(DDMShape) == 80, "DDMShape layout changed");
+static_assert(sizeof(DDMShapeDelta) == 24, "DDMShapeDelta layout changed");
+static_assert(sizeof(DDBHeader) == 80, "DDBHeader layout changed");
+static_assert(sizeof(DDBJoint) == 80, "DDBJoint layout changed");
+static_assert(sizeof(DDBInvBind) == 48, "DDBInvBind layout changed");
+static_assert(sizeof(DDAHeader) == 64, "DDAHeader layout changed");
+static_assert(sizeof(DDAShape) == 80, "DDAShape layout changed");
+static_assert(sizeof(DDAJoint) == 16, "DDAJoint layout changed");
+static_assert(sizeof(DDAQuantRange) == 48, "DDAQuantRange layout changed");
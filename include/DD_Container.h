@@ -1,6 +1,8 @@
 #pragma once
 
 #include <algorithm>
+#include <new>
+#include <utility>
 #include <Pow2Assert.h>
 
 /*
@@ -14,6 +16,10 @@
 *		- array container
 *			- can be accessed w/ []
 *			- can be resized
+*			- can grow in place (reserve/push_back keep existing elements)
+*			- opt-in uninitialized allocation (resizeUninit)
+*			- storage policy (heap by default, scratch arena w/ DD_Arena.h)
+*			- unchecked data()/begin()/end() access for hot loops
 *			- has validation check
 *			- reports n size & n byte size
 *	dd_2Darray:
@@ -25,67 +31,133 @@
 *	TODO:
 *
 *	Uses POW_ASSERT
+*		- [] bounds checks compile out w/ DD_UNCHECKED_ACCESS (set for
+*		  non-Debug configs by CMakeLists.txt unless DD_CHECKED_RELEASE=ON)
 -----------------------------------------------------------------------------*/
 
+#ifdef DD_UNCHECKED_ACCESS
+#define DD_BOUNDS_CHECK(cond, msg) do {} while(0)
+#else
+#define DD_BOUNDS_CHECK(cond, msg) POW2_VERIFY_MSG(cond, msg, 0)
+#endif // DD_UNCHECKED_ACCESS
+
+/// \brief Default dd_array storage (global heap)
+struct dd_heap_alloc
+{
+	static void* allocate(const size_t bytes, const size_t /*align*/)
+	{
+		return ::operator new(bytes);
+	}
+	static void deallocate(void* ptr, const size_t /*bytes*/)
+	{
+		::operator delete(ptr);
+	}
+};
+
 // Array container used for Day Dream engine
-template <class T>
+// Alloc: storage policy w/ static allocate(bytes, align) &
+// deallocate(ptr, bytes)
+// (see dd_scratch_alloc in DD_Arena.h)
+template <class T, class Alloc = dd_heap_alloc>
 class dd_array
 {
 public:
 	// ctor
-	dd_array(const size_t _size = 0) : m_size(_size)
+	dd_array(const size_t _size = 0) :
+		m_size(0),
+		m_capacity(0),
+		m_data(nullptr)
 	{
-		if( _size != 0 ) {
-			m_data = new T[_size]();
-		}
-		else {
-			m_data = nullptr;
-		}
+		allocate(_size, true);
 	}
 	// dtor
 	~dd_array()
 	{
-		if( m_size > 0 ) {
-			delete[] m_data;
-		}
+		release();
 	}
 	// copy ctor
-	dd_array(const dd_array& other)
+	dd_array(const dd_array& other) :
+		m_size(0),
+		m_capacity(0),
+		m_data(nullptr)
 	{
-		m_size = other.m_size;
-		m_data = new T[m_size]();
-		std::copy(other.m_data, other.m_data + m_size, m_data);
+		if( other.m_size != 0 ) {
+			allocate(other.m_size, true);
+			std::copy(other.m_data, other.m_data + m_size, m_data);
+		}
 	}
 
-	// set size
+	// set size (old contents are discarded, elements are value-initialized)
 	bool resize(const size_t _size)
 	{
-		if( m_size > 0 ) {
-			delete[] m_data;
-			m_size = 0;
+		return allocate(_size, true);
+	}
+
+	// set size w/o value-initializing the new block. Trivially constructible
+	// types (char, float, ...) are left uninitialized, so only use this when
+	// every element is written before it is read
+	bool resizeUninit(const size_t _size)
+	{
+		return allocate(_size, false);
+	}
+
+	// set size keeping existing elements (added elements are
+	// value-initialized)
+	void resizeKeep(const size_t _size)
+	{
+		if( _size > m_capacity ) {
+			reallocate(_size);
 		}
-		if( _size != 0 ) {
-			m_size = _size;
-			m_data = new T[_size]();
+		for( size_t i = m_size; i < _size; i++ ) {
+			m_data[i] = T();
 		}
-		return isValid();
+		m_size = _size;
+	}
+
+	// make room for at least _capacity elements (contents are kept)
+	void reserve(const size_t _capacity)
+	{
+		if( _capacity > m_capacity ) {
+			reallocate(_capacity);
+		}
+	}
+
+	// append element (capacity doubles when full)
+	void push_back(const T& value)
+	{
+		emplace_back(value);
+	}
+	void push_back(T&& value)
+	{
+		emplace_back(std::move(value));
 	}
+	// append element built from args. The element is built before growing
+	// (args may refer into this array) and then moved into the slot
+	template <class... Args>
+	T & emplace_back(Args&&... args)
+	{
+		T value(std::forward<Args>(args)...);
+		if( m_size == m_capacity ) {
+			reallocate(std::max<size_t>(m_capacity * 2, 8));
+		}
+		m_data[m_size] = std::move(value);
+		return m_data[m_size++];
+	}
+
+	// drop all elements (storage is kept for reuse)
+	void clear() { m_size = 0; }
 
 	// returns T from 1D array
 	T & operator[](const size_t FirstIndex)
 	{
-		POW2_VERIFY_MSG(
-			FirstIndex < m_size,
-			"Index out of bounds :: 1D", 0);
+		DD_BOUNDS_CHECK(FirstIndex < m_size, "Index out of bounds :: 1D");
 		return m_data[FirstIndex];
 	}
 
 	// returns const T from 1D array
 	T & operator[](const size_t FirstIndex) const
 	{
-		POW2_VERIFY_MSG(
-			FirstIndex < m_size,
-			"Index out of bounds :: 1D", 0);
+		DD_BOUNDS_CHECK(FirstIndex < m_size, "Index out of bounds :: 1D");
 		return m_data[FirstIndex];
 	}
 
@@ -96,8 +168,10 @@ public:
 			return;		// nothing in the second array
 		}
 		if( m_size == 0 ) {	// nothing in this array
+			if( m_capacity < other.m_size ) {
+				allocate(other.m_size, true);
+			}
 			m_size = other.m_size;
-			m_data = new T[m_size]();
 		}
 
 		if( m_size >= other.m_size ) { // other array is smaller
@@ -109,40 +183,104 @@ public:
 	}
 
 	// move ctor
-	dd_array(dd_array&& other) : m_size(0), m_data(nullptr)
+	dd_array(dd_array&& other) : m_size(0), m_capacity(0), m_data(nullptr)
 	{
 		m_data = other.m_data;
 		m_size = other.m_size;
+		m_capacity = other.m_capacity;
 
 		other.m_data = nullptr;
 		other.m_size = 0;
+		other.m_capacity = 0;
 	}
 
 	// move assignment
 	dd_array& operator=(dd_array&& other)
 	{
 		if( this != &other ) {
-			if( m_data != nullptr ) {
-				delete[] m_data;
-			}
+			release();
 			m_data = other.m_data;
 			m_size = other.m_size;
+			m_capacity = other.m_capacity;
 
 			other.m_size = 0;
+			other.m_capacity = 0;
 			other.m_data = nullptr;
 		}
 		return *this;
 	}
 
+	// unchecked access (nullptr when empty)
+	inline T* data() { return m_data; }
+	inline const T* data() const { return m_data; }
+	inline T* begin() { return m_data; }
+	inline T* end() { return m_data + m_size; }
+	inline const T* begin() const { return m_data; }
+	inline const T* end() const { return m_data + m_size; }
+
 	// number of elements
 	inline size_t size() const { return m_size; }
+	// number of elements allocated
+	inline size_t capacity() const { return m_capacity; }
 	// size of data in bytes
 	inline size_t sizeInBytes() const { return m_size * sizeof(T); }
-	// checks is data was allocated in memory
-	inline bool isValid() const { return (m_data == nullptr) ? false : true; }
+	// checks if array holds any elements
+	inline bool isValid() const { return m_size > 0; }
 
 private:
+	// raw block w/ every slot constructed (slots past m_size are spare)
+	static T* construct(const size_t count, const bool value_init)
+	{
+		T *data = (T*)Alloc::allocate(count * sizeof(T), alignof(T));
+		for( size_t i = 0; i < count; i++ ) {
+			if( value_init ) {
+				new (data + i) T();
+			}
+			else {
+				new (data + i) T;
+			}
+		}
+		return data;
+	}
+	// destroy every slot and hand the block back
+	void release()
+	{
+		if( m_data ) {
+			for( size_t i = 0; i < m_capacity; i++ ) {
+				m_data[i].~T();
+			}
+			Alloc::deallocate(m_data, m_capacity * sizeof(T));
+		}
+		m_data = nullptr;
+		m_size = 0;
+		m_capacity = 0;
+	}
+	// replace storage w/ a fresh block of _size elements
+	bool allocate(const size_t _size, const bool value_init)
+	{
+		release();
+		if( _size != 0 ) {
+			m_data = construct(_size, value_init);
+			m_size = _size;
+			m_capacity = _size;
+		}
+		return isValid();
+	}
+	// move contents to a block of _capacity elements (spare slots are
+	// default-initialized and always assigned before use)
+	void reallocate(const size_t _capacity)
+	{
+		T *data = construct(_capacity, false);
+		std::move(m_data, m_data + m_size, data);
+		const size_t size = m_size;
+		release();
+		m_data = data;
+		m_size = size;
+		m_capacity = _capacity;
+	}
+
 	size_t m_size;
+	size_t m_capacity;
 	T *m_data;
 };
 
@@ -214,17 +352,17 @@ public:
 	// return 2D data
 	T & GetElement(size_t FirstIndex, size_t SecondIndex)
 	{
-		POW2_VERIFY_MSG(
+		DD_BOUNDS_CHECK(
 			(FirstIndex * m_column + SecondIndex) < (m_column * m_row),
-			"Index out of bounds :: 2D", 0);
+			"Index out of bounds :: 2D");
 		return m_data[(FirstIndex * m_column) + SecondIndex];
 	}
 	// return const 2D data
 	T & GetElement(size_t FirstIndex, size_t SecondIndex) const
 	{
-		POW2_VERIFY_MSG(
+		DD_BOUNDS_CHECK(
 			(FirstIndex * m_column + SecondIndex) < (m_column * m_row),
-			"Index out of bounds :: 2D", 0);
+			"Index out of bounds :: 2D");
 		return m_data[(FirstIndex * m_column) + SecondIndex];
 	}
 
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <DD_String.h>
+
+/*-----------------------------------------------------------------------------
+*
+*	dd_string_pool:
+*		- process-wide table of interned strings
+*			- each distinct string is stored once and named by a 32-bit handle
+*			  that stays valid until the process exits
+*			- hash (getCharHash, same value as cbuff) is computed once when the
+*			  string is interned
+*		- intern/find lock one mutex, reading a handle's string or hash takes
+*		  no lock (entry pages never move)
+*	dd_istr:
+*		- interned string handle w/ cbuff's set/str/gethash interface
+*			- 4 bytes, no length limit
+*			- copy and compare are a 32-bit copy and compare
+*
+-----------------------------------------------------------------------------*/
+
+#define DD_INTERN_PAGE_BITS 12
+#define DD_INTERN_PAGE_SIZE (1u << DD_INTERN_PAGE_BITS)	// entries per page
+#define DD_INTERN_MAX_PAGES 4096						// 16M strings
+#define DD_INTERN_CHAR_BLOCK (64 << 10)
+#define DD_INTERN_NONE ((uint32_t)-1)					// find() miss
+
+class dd_string_pool
+{
+public:
+	struct Entry
+	{
+		const char*	str;
+		uint32_t	len;
+		size_t		hash;
+	};
+
+	/// \brief The global pool (handle 0 is the empty string)
+	static dd_string_pool& get()
+	{
+		static dd_string_pool pool;
+		return pool;
+	}
+
+	/// \brief Handle of str (added to the pool on first use)
+	uint32_t intern(const char* str)
+	{
+		const size_t hash = getCharHash(str);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		const uint32_t found = lookup(str, hash);
+		if( found != DD_INTERN_NONE ) {
+			return found;
+		}
+		return add(str, hash);
+	}
+
+	/// \brief Handle of an interned string (DD_INTERN_NONE if it never was)
+	uint32_t find(const char* str)
+	{
+		const size_t hash = getCharHash(str);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return lookup(str, hash);
+	}
+
+	inline const Entry& entry(const uint32_t handle) const
+	{
+		return m_pages[handle >> DD_INTERN_PAGE_BITS]
+			[handle & (DD_INTERN_PAGE_SIZE - 1)];
+	}
+
+	/// \brief # of distinct strings
+	uint32_t size()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_count;
+	}
+
+private:
+	dd_string_pool() : m_count(0), m_charUsed(DD_INTERN_CHAR_BLOCK)
+	{
+		memset(m_pages, 0, sizeof(m_pages));
+		add("", getCharHash(""));
+	}
+	~dd_string_pool()
+	{
+		for( Entry* page : m_pages ) {
+			delete[] page;
+		}
+		for( char* block : m_chars ) {
+			delete[] block;
+		}
+	}
+
+	uint32_t lookup(const char* str, const size_t hash) const
+	{
+		auto range = m_lookup.equal_range(hash);
+		for( auto it = range.first; it != range.second; ++it ) {
+			if( strcmp(entry(it->second).str, str) == 0 ) {
+				return it->second;
+			}
+		}
+		return DD_INTERN_NONE;
+	}
+
+	uint32_t add(const char* str, const size_t hash)
+	{
+		const uint32_t handle = m_count;
+		const uint32_t page = handle >> DD_INTERN_PAGE_BITS;
+		POW2_VERIFY_MSG(page < DD_INTERN_MAX_PAGES, "String pool full", 0);
+		if( page >= DD_INTERN_MAX_PAGES ) {
+			printf("String pool full, dropping: %s\n", str);
+			return 0;
+		}
+		if( !m_pages[page] ) {
+			m_pages[page] = new Entry[DD_INTERN_PAGE_SIZE];
+		}
+
+		// chars are packed into blocks (long strings get their own block)
+		const size_t len = strlen(str);
+		char* chars = nullptr;
+		if( len + 1 > DD_INTERN_CHAR_BLOCK / 4 ) {
+			chars = new char[len + 1];
+			m_chars.push_back(chars);
+		}
+		else {
+			if( m_charUsed + len + 1 > DD_INTERN_CHAR_BLOCK ) {
+				m_chars.push_back(new char[DD_INTERN_CHAR_BLOCK]);
+				m_charBlock = m_chars.back();
+				m_charUsed = 0;
+			}
+			chars = m_charBlock + m_charUsed;
+			m_charUsed += len + 1;
+		}
+		memcpy(chars, str, len + 1);
+
+		Entry& new_entry = m_pages[page][handle & (DD_INTERN_PAGE_SIZE - 1)];
+		new_entry.str = chars;
+		new_entry.len = (uint32_t)len;
+		new_entry.hash = hash;
+		m_lookup.emplace(hash, handle);
+		m_count += 1;
+		return handle;
+	}
+
+	Entry*				m_pages[DD_INTERN_MAX_PAGES];
+	uint32_t			m_count;
+	std::vector<char*>	m_chars;		// string storage blocks
+	char*				m_charBlock;	// block being filled
+	size_t				m_charUsed;
+	std::unordered_multimap<size_t, uint32_t>	m_lookup;	// hash -> handle
+	std::mutex			m_mutex;
+
+	dd_string_pool(const dd_string_pool&);
+	dd_string_pool& operator=(const dd_string_pool&);
+};
+
+// interned string (4 bytes)
+struct dd_istr
+{
+	dd_istr() : m_handle(0) {}
+	dd_istr(const char* in_str) { set(in_str); }
+
+	bool operator==(const dd_istr &other) const
+	{
+		return m_handle == other.m_handle;
+	}
+
+	bool operator!=(const dd_istr &other) const
+	{
+		return m_handle != other.m_handle;
+	}
+
+	dd_istr& operator=(const char* in_str)
+	{
+		set(in_str);
+		return *this;
+	}
+
+	/// \brief Orders by handle (interning order, not alphabetical)
+	bool operator<(const dd_istr &other) const
+	{
+		return m_handle < other.m_handle;
+	}
+
+	void set(const char* in_str)
+	{
+		m_handle = dd_string_pool::get().intern(in_str);
+	}
+
+	const char* str() const { return dd_string_pool::get().entry(m_handle).str; }
+	uint32_t length() const { return dd_string_pool::get().entry(m_handle).len; }
+	size_t gethash() const { return dd_string_pool::get().entry(m_handle).hash; }
+	uint32_t handle() const { return m_handle; }
+private:
+	uint32_t m_handle;
+};
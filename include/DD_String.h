@@ -19,6 +19,8 @@ static size_t getCharHash(const char* s)
 }
 
 // small container (8 bytes + T)
+// hash is computed on first use (gethash/==/<) and cached, so buffers that
+// are only formatted and printed never pay for it
 template <const int T>
 struct cbuff
 {
@@ -36,7 +38,7 @@ struct cbuff
 
 	bool operator==(const cbuff &other) const
 	{
-		return hash == other.hash;
+		return gethash() == other.gethash();
 	}
 
 	cbuff& operator=(const char* in_str)
@@ -47,27 +49,34 @@ struct cbuff
 
 	bool operator<(const cbuff &other) const
 	{
-		return hash < other.hash;
+		return gethash() < other.gethash();
 	}
 
 	void set(const char* in_str)
 	{
 		snprintf(cstr, T, "%s", in_str);
-		hash = getCharHash(cstr);
+		hash = 0;
 	}
 
 	template<typename... Args>
 	void format(const char* format_str, const Args&... args)
 	{
 		snprintf(cstr, T, format_str, args...);
-		hash = getCharHash(cstr);
+		hash = 0;
 	}
 
 	const char* str() const { return cstr; }
-	size_t gethash() const { return hash; }
+	size_t gethash() const
+	{
+		// 0 marks a stale hash (a string hashing to 0 is just rehashed)
+		if (hash == 0) {
+			hash = getCharHash(cstr);
+		}
+		return hash;
+	}
 private:
 	char cstr[T];
-	size_t hash;
+	mutable size_t hash;
 };
 
 namespace StrSpace
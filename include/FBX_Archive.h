@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FBX_Stream.h"
+#include <DD_Container.h>
+
+/*-----------------------------------------------------------------------------
+*
+*	ZipArchiveFBX:
+*		- read-only zip reader over a mapped archive
+*			- lists entries from the central directory
+*			- extracts stored or deflated (zlib, DD_USE_ZLIB) entries to memory
+*			- crc checked
+*		- no zip64, encryption or multi-disk archives
+*
+-----------------------------------------------------------------------------*/
+
+/// \brief Zip central directory record
+struct ZipEntryFBX
+{
+	std::string	name;
+	uint16_t	method;			// 0: stored, 8: deflate
+	uint32_t	crc;
+	uint64_t	comp_size;
+	uint64_t	size;
+	uint64_t	header_offset;	// local file header
+};
+
+class ZipArchiveFBX
+{
+public:
+	/// \brief Map archive and read its central directory
+	bool open(const char* fileName);
+	/// \brief Decompress entry into buffer (resized to the entry size)
+	bool extract(const ZipEntryFBX& entry, dd_array<char>& buffer) const;
+	/// \brief Find entry by name (nullptr if missing)
+	const ZipEntryFBX* find(const std::string& name) const;
+
+	inline const std::vector<ZipEntryFBX>& entries() const { return m_entries; }
+
+private:
+	MemStreamFBX				m_file;
+	std::vector<ZipEntryFBX>	m_entries;
+};
@@ -2,24 +2,39 @@
 #include "FBX_Utility.h"
 #include <typeinfo>
 #include <string>
+#include <vector>
 
 void processAsset(FbxNode* node, 
 				  AssetFBX &_asset, 
 				  bool export_skeleton,
-				  bool export_mesh);
+				  bool export_mesh,
+				  bool export_mesh_bin = false,
+				  bool export_skeleton_bin = false);
 void processSkeletonAsset(FbxNode *node, const size_t index, AssetFBX &_asset);
+void storeInvBind(const FbxAMatrix &mat, float out[12]);
 void processAnimation(FbxNode *node,
 					  FbxAnimStack *animstack,
 					  AssetFBX &_asset,
 					  const float framerate,
 					  const char* stack_name);
+void reduceKeyframes(AnimClipFBX &clip, const float pos_tol,
+					 const float rot_tol, const float scale_factor);
 
 // functions for mesh and animation parsing
 void processMesh(FbxNode *node, MeshFBX &new_mesh);
+void processBlendShapes(FbxMesh *currmesh, MeshFBX &mesh, const float epsilon);
+void sampleShapeWeights(FbxNode *node, FbxAnimLayer *animlayer,
+						AnimClipFBX &clip);
+void weldVerts(MeshFBX &mesh, const float epsilon);
 dd_array<size_t> connectMatToMesh(FbxNode *node, MeshFBX &mesh,
 								  const uint8_t num_mats);
 dd_array<MatFBX> processMats(FbxNode *node);
-void processSkeleton(FbxGeometry *_geom, MeshFBX &mesh, SkelFbx& _sk);
+void processSkeleton(FbxGeometry *_geom, MeshFBX &mesh, SkelFbx& _sk,
+					 std::vector<SkinInfluence> &influences);
+float resolveSkinWeights(MeshFBX &mesh,
+						 const std::vector<SkinInfluence> &influences,
+						 const unsigned max_influences,
+						 const unsigned weight_bits);
 
 template<class T>
 void getVertInfo(T info_type,
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <fbxsdk.h>
+
+/*-----------------------------------------------------------------------------
+*
+*	MemStreamFBX:
+*		- read-only FbxStream over a block of memory
+*			- mapFile: read-only mmap of a file (stream owns the mapping)
+*			- setBuffer: caller owned buffer (must outlive the import)
+*		- passed to FbxImporter::Initialize(FbxStream*, ...) so the SDK reads
+*		  straight from memory instead of doing its own buffered file reads
+*
+-----------------------------------------------------------------------------*/
+
+class MemStreamFBX : public FbxStream
+{
+public:
+	MemStreamFBX();
+	~MemStreamFBX();
+
+	/// \brief Map file read-only and hint the kernel to start reading it in
+	bool mapFile(const char* fileName);
+	/// \brief Stream from memory owned by the caller
+	void setBuffer(const void* data, const size_t size);
+	/// \brief Unmap / drop the current source
+	void release();
+	/// \brief Start reading a file into the page cache without mapping it
+	/// (whoever maps it next finds it resident)
+	static void prefetchFile(const char* fileName);
+	/// \brief Reader id used by FbxImporter::Initialize (fbx reader of manager)
+	void setReaderID(FbxManager* sdkManager);
+
+	inline bool isValid() const { return m_data != nullptr; }
+	inline const char* data() const { return m_data; }
+	inline size_t size() const { return m_size; }
+
+	// FbxStream interface
+	using FbxStream::Read;
+	using FbxStream::Write;
+	EState GetState() override;
+	bool Open(void* pStreamData) override;
+	bool Close() override;
+	bool Flush() override;
+	int Write(const void* pData, int pSize) override;
+	int Read(void* pData, int pSize) const override;
+	char* ReadString(char* pBuffer,
+					 int pMaxSize,
+					 bool pStopAtFirstWhiteSpace = false) override;
+	int GetReaderID() const override;
+	int GetWriterID() const override;
+	void Seek(const FbxInt64& pOffset, const FbxFile::ESeekPos& pSeekPos) override;
+	long GetPosition() const override;
+	void SetPosition(long pPosition) override;
+	int GetError() const override;
+	void ClearError() override;
+
+private:
+	const char*		m_data;
+	size_t			m_size;
+	mutable size_t	m_pos;
+	EState			m_state;
+	int				m_readerId;
+	bool			m_mapped;
+#ifdef _WIN32
+	void*			m_fileHandle;
+	void*			m_mapHandle;
+#endif // _WIN32
+
+	MemStreamFBX(const MemStreamFBX&);
+	MemStreamFBX& operator=(const MemStreamFBX&);
+};
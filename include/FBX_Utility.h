@@ -4,11 +4,16 @@
 #include <cstdlib>
 #include <map>
 #include <functional>
+#include <unordered_map>
 #include <fbxsdk.h>
 #include <DD_Container.h>
+#include <DD_Arena.h>
 #include <DD_String.h>
+#include <DD_Intern.h>
+#include "FBX_Writer.h"
 
-#define MAX_JOINTS ((uint8_t)-1)
+/// Joint indices are 16-bit (the last value is left free as "no joint")
+#define MAX_JOINTS ((uint16_t)-1)
 
 template<typename T>
 struct dd_vec4
@@ -71,6 +76,7 @@ CREATE_VEC(float, f, 4)
 CREATE_VEC(float, f, 3)
 CREATE_VEC(float, f, 2)
 CREATE_VEC(uint32_t, u, 4)
+CREATE_VEC(uint16_t, u16, 4)
 CREATE_VEC(uint32_t, u, 3)
 
 // Enum bitwise flags
@@ -120,7 +126,7 @@ operator &(Enum lhs, Enum rhs)
 /// Triangle information (uses typedef arrays for least amount of padding)
 struct VertPNTUV
 {
-	vec4_u m_joint;
+	vec4_u16 m_joint;
 	vec4_f m_jblend;
 	vec3_f m_pos;
 	vec3_f m_norm;
@@ -134,29 +140,46 @@ struct TriFBX
 	size_t		m_mat_idx;
 };
 
+/// Joint influences kept per vertex (VertPNTUV / DDM joint and blend slots)
+#define MAX_INFLUENCES 4
+
 struct CtrlPnt
 {
 	CtrlPnt()
 	{
-		for (size_t i = 0; i < 4; i++) {
+		for (size_t i = 0; i < MAX_INFLUENCES; i++) {
 			m_joint[i] = 0;
 			m_blend[i] = 0;
 		}
 	}
 	vec3_f		m_pos;
-	unsigned	m_joint[4];
-	float		m_blend[4];
-	// add joint blend weights to control point
-	void addBWPair(const uint16_t idx, const float bw)
-	{
-		limit += 1;
-		if( limit < 4 ) {
-			m_joint[limit - 1] = idx;
-			m_blend[limit - 1] = bw;
-		}
-	}
-private:
-	uint8_t limit = 0;
+	uint16_t	m_joint[MAX_INFLUENCES];	// sorted by weight (largest first)
+	float		m_blend[MAX_INFLUENCES];	// sums to 1 when skinned
+};
+
+/// \brief Cluster weight of one control point (skin weight scratch pool)
+struct SkinInfluence
+{
+	uint32_t	m_ctrlpnt;
+	uint16_t	m_joint;
+	float		m_weight;
+};
+
+/// \brief Blend shape target stored sparse: deltas only for the vertices that
+/// move (indices follow the mesh's current vertex order)
+struct ShapeFBX
+{
+	ShapeFBX() {}
+	ShapeFBX(const char* name) { m_id.set(name); }
+
+	dd_istr				m_id;		// blend shape channel name
+	dd_array<uint32_t>	m_indices;	// ascending vertex indices
+	dd_array<vec3_f>	m_dpos;		// position deltas
+	dd_array<vec3_f>	m_dnorm;	// normal deltas
+
+	/// \brief Move deltas to a new vertex order (old index -> new index).
+	/// Entries that land on the same vertex keep the first one
+	void remap(const dd_array<uint32_t> &new_idx);
 };
 
 struct MeshFBX
@@ -164,34 +187,83 @@ struct MeshFBX
 	MeshFBX() {}
 	MeshFBX(const char* name) { m_id.set(name); }
 
-	cbuff<32>			m_id;
+	dd_istr				m_id;
 	dd_array<TriFBX>	m_triangles;
 	dd_array<CtrlPnt>	m_ctrlpnts;
 	dd_array<VertPNTUV> m_verts;
+	dd_array<ShapeFBX>	m_shapes;
 
 	bool operator==(const MeshFBX &other) const
 	{
-		return m_id.gethash() == other.m_id.gethash();
+		return m_id == other.m_id;
 	}
 };
 
 struct JointFBX
 {
-	cbuff<32>	m_name;
-	uint8_t		m_idx;
-	uint8_t		m_parent;
+	dd_istr		m_name;
+	uint16_t	m_idx;
+	uint16_t	m_parent;
 	vec3_f		m_lspos = { 0, 0, 0 };
 	vec3_f		m_lsrot = { 0, 0, 0 };
 	vec3_f		m_lsscl = { 1, 1, 1 };
+	// inverse bind matrix (3x4 row-major, see DDBInvBind)
+	float		m_invBind[12] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0 };
 };
 
 struct SkelFbx
 {
-	JointFBX 	m_joints[MAX_JOINTS];
-	uint8_t		m_numJoints = 0;
+	dd_array<JointFBX>	m_joints;	// grown on demand (see addJoint)
+	uint16_t	m_numJoints = 0;
 	vec3_f		m_wspos = { 0, 0, 0 };
 	vec3_f		m_wsrot = { 0, 0, 0 };
 	vec3_f		m_wsscl = { 1, 1, 1 };
+	// joint lookup tables (filled by processSkeletonAsset)
+	std::unordered_map<const FbxNode*, uint16_t> m_nodeIndex;
+	std::unordered_map<uint32_t, uint16_t> m_nameIndex;	// name handle -> joint
+
+	/// \brief Append joint to the table (existing joints are kept). Returns
+	/// nullptr once MAX_JOINTS joints are recorded
+	JointFBX* addJoint()
+	{
+		if (m_numJoints == MAX_JOINTS) {
+			return nullptr;
+		}
+		JointFBX* joint = &m_joints.emplace_back();
+		joint->m_idx = m_numJoints;
+		m_numJoints += 1;
+		return joint;
+	}
+
+	/// \brief Register joint for O(1) lookup by node or name (first joint
+	/// with a name wins, same as the old linear name scans)
+	void indexJoint(const FbxNode* node, const uint16_t idx)
+	{
+		m_nodeIndex[node] = idx;
+		m_nameIndex.emplace(m_joints[idx].m_name.handle(), idx);
+	}
+
+	/// \brief Reorder joints so every parent precedes its children (lookup
+	/// tables are remapped). Returns true if any joint moved
+	bool sortTopological();
+
+	/// \brief Joint index of node (-1 if node is not a joint)
+	int findJoint(const FbxNode* node) const
+	{
+		auto by_node = m_nodeIndex.find(node);
+		if (by_node != m_nodeIndex.end()) {
+			return by_node->second;
+		}
+		return findJoint(node->GetName());
+	}
+
+	/// \brief Joint index by name (-1 if not found)
+	int findJoint(const char* name) const
+	{
+		// a name that was never interned can't belong to a joint
+		auto by_name = m_nameIndex.find(dd_string_pool::get().find(name));
+		return (by_name != m_nameIndex.end()) ? by_name->second : -1;
+	}
 };
 
 enum class MatType
@@ -222,26 +294,26 @@ struct MatFBX
 	MatFBX() {}
 	MatFBX(const char* name) { m_id.set(name); }
 
-	cbuff<128>	m_diffmap;
-	cbuff<128>	m_normmap;
-	cbuff<128>	m_specmap;
-	cbuff<128>	m_roughmap;
-	cbuff<128>	m_emitmap;
-	cbuff<128>	m_aomap;
-	cbuff<128>	m_metalmap;
-	cbuff<64>	m_id;
+	dd_istr		m_diffmap;
+	dd_istr		m_normmap;
+	dd_istr		m_specmap;
+	dd_istr		m_roughmap;
+	dd_istr		m_emitmap;
+	dd_istr		m_aomap;
+	dd_istr		m_metalmap;
+	dd_istr		m_id;
 	vec3_f		m_ambient;
 	vec3_f		m_diffuse;
 	vec3_f		m_specular;
 	vec3_f		m_emmisive;
-	float		m_transfactor;
-	float		m_reflectfactor;
-	float		m_specfactor;
+	float		m_transfactor = 0.f;
+	float		m_reflectfactor = 0.f;
+	float		m_specfactor = 0.f;
 	MatType	m_textypes = MatType::NONE;
 
 	bool operator==(const MatFBX &other) const
 	{
-		return m_id.gethash() == other.m_id.gethash();
+		return m_id == other.m_id;
 	}
 };
 
@@ -252,22 +324,80 @@ struct AnimSample
 	//float		scal;
 };
 
-struct PoseSample
-{
-	dd_array<AnimSample> pose;
-	dd_array<vec3_u> logged_r;
-	dd_array<vec3_u> logged_t;
-};
+/// Logged channel bits per joint sample (rotation xyz then position xyz)
+#define ANIM_CHANNELS 6
 
 struct AnimClipFBX
 {
 	AnimClipFBX() {}
 	AnimClipFBX(const char* name) { m_id.set(name); } 
 
-	cbuff<64> 	m_id;
+	dd_istr		m_id;
 	float		m_framerate;
-	uint8_t		m_joints;
-	std::map<unsigned, PoseSample> m_clip;
+	uint16_t	m_joints;
+	uint32_t	m_frames = 0;		// # of frames sampled
+	uint32_t	m_capacity = 0;		// # of frames allocated
+	// pose store (scratch arena: dropped once the asset is exported)
+	dd_scratch_array<AnimSample> m_samples;	// frame-major (frame * m_joints + joint)
+	dd_scratch_array<uint64_t>	m_logged;	// bitset of keyed channels per sample
+	dd_scratch_array<uint32_t>	m_keys;		// reduced key frames of every joint
+	dd_scratch_array<uint32_t>	m_keyOffsets;	// joint -> first key (m_joints + 1)
+	uint32_t	m_numShapes = 0;			// blend shape weight tracks
+	dd_array<dd_istr>	m_shapeIds;		// blend shape channel names
+	dd_scratch_array<float>	m_shapeWeights;	// shape-major (shape * m_frames + frame)
+
+	/// \brief Allocate dense frame storage (existing samples are preserved)
+	void reserveFrames(const uint32_t frames)
+	{
+		if (frames <= m_capacity) {
+			return;
+		}
+		const size_t num_samples = (size_t)frames * m_joints;
+		m_samples.resizeKeep(num_samples);
+		m_logged.resizeKeep((num_samples * ANIM_CHANNELS + 63) / 64);
+		m_capacity = frames;
+	}
+
+	AnimSample& sample(const uint32_t frame, const uint32_t joint)
+	{
+		return m_samples[(size_t)frame * m_joints + joint];
+	}
+
+	const AnimSample& sample(const uint32_t frame, const uint32_t joint) const
+	{
+		return m_samples[(size_t)frame * m_joints + joint];
+	}
+
+	void setLogged(const uint32_t frame, const uint32_t joint,
+				   const unsigned channel)
+	{
+		const size_t bit =
+			((size_t)frame * m_joints + joint) * ANIM_CHANNELS + channel;
+		m_logged[bit >> 6] |= (uint64_t)1 << (bit & 63);
+	}
+
+	bool isLogged(const uint32_t frame, const uint32_t joint,
+				  const unsigned channel) const
+	{
+		const size_t bit =
+			((size_t)frame * m_joints + joint) * ANIM_CHANNELS + channel;
+		return (m_logged[bit >> 6] >> (bit & 63)) & 1;
+	}
+
+	/// \brief Keyframe reduction was run (tracks carry explicit key frames)
+	bool isReduced() const { return m_keyOffsets.size() > 0; }
+
+	uint32_t numKeys(const uint32_t joint) const
+	{
+		return isReduced() ?
+			m_keyOffsets[joint + 1] - m_keyOffsets[joint] : m_frames;
+	}
+
+	/// \brief Frame of a joint's k-th key (every frame is a key if not reduced)
+	uint32_t keyFrame(const uint32_t joint, const uint32_t k) const
+	{
+		return isReduced() ? m_keys[m_keyOffsets[joint] + k] : k;
+	}
 };
 
 struct AssetFBX
@@ -278,22 +408,64 @@ struct AssetFBX
 		m_verts(0), 
 		m_ebos(0), 
 		m_clips(0), 
-		m_viconFormat(false) 
+		m_viconFormat(false),
+		m_weldVerts(false),
+		m_weldEpsilon(0.f),
+		m_optimizeCache(false),
+		m_curveSampler(false),
+		m_parallelSampling(false),
+		m_posTolerance(-1.f),
+		m_rotTolerance(-1.f),
+		m_quantBits(0),
+		m_compression(TextCompression::NONE),
+		m_compressLevel(-1),
+		m_maxInfluences(MAX_INFLUENCES),
+		m_weightBits(0),
+		m_shapeEpsilon(1e-5f),
+		m_exportFailed(false)
 	{}
 
-	cbuff<32>			m_id;
+	dd_istr				m_id;
 	cbuff<64>			m_fbxName;
 	cbuff<512>			m_fbxPath;
 	dd_array<MatFBX> 	m_matbin;
 	dd_array<VertPNTUV> m_verts;
 	dd_array<EboMesh> 	m_ebos;
+	dd_array<ShapeFBX>	m_shapes;
 	SkelFbx				m_skeleton;
 	dd_array<AnimClipFBX> m_clips;
 	bool				m_viconFormat;
+	bool				m_weldVerts;
+	float				m_weldEpsilon;
+	bool				m_optimizeCache;
+	bool				m_curveSampler;
+	bool				m_parallelSampling;
+	float				m_posTolerance;	// keyframe reduction (< 0 is off)
+	float				m_rotTolerance;
+	uint32_t			m_quantBits;	// binary track fixed point bits (0 is off)
+	TextCompression		m_compression;	// text DDM/DDB/DDA output stream
+	int					m_compressLevel;
+	uint32_t			m_maxInfluences;	// skin weights kept per vertex (top-k)
+	uint32_t			m_weightBits;	// unorm skin weight bits (0 is off)
+	float				m_shapeEpsilon;	// blend shape delta cutoff
 	float				scale_factor;
+	bool				m_exportFailed;	// an output file is missing or incomplete
 
 	void addMesh(MeshFBX& _mesh, dd_array<size_t> &ebo_data);
+	void optimizeVertCache();
 	void exportMesh();
+	void exportMeshBinary();
 	void exportSkeleton();
+	void exportSkeletonBinary();
 	void exportAnimation();
+	void exportAnimationBinary();
+
+	/// \brief Flag output file that could not be written completely
+	void checkWrite(const bool failed, const char* file)
+	{
+		if (failed) {
+			printf("Write failed, output incomplete: %s\n", file);
+			m_exportFailed = true;
+		}
+	}
 };
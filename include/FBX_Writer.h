@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <DD_Container.h>
+
+/*-----------------------------------------------------------------------------
+*
+*	TextWriterFBX:
+*		- buffered writer for the text DDM/DDB/DDA formats
+*			- lines are built in one large reusable buffer and written out in
+*			  big chunks (no per-line snprintf or cbuff hashing)
+*			- floats are printed with the exporter's fixed "%.3f" format
+*			  without going through printf
+*		- optional inline gzip (DD_USE_ZLIB) or zstd (DD_USE_ZSTD) output
+*			- full chunks are handed to a background thread that compresses
+*			  and writes them while the next chunk is being filled
+*
+-----------------------------------------------------------------------------*/
+
+#define TEXT_WRITER_BUFFER_SIZE (1 << 20)
+
+enum class TextCompression : unsigned
+{
+	NONE,
+	GZIP,	// .gz
+	ZSTD	// .zst
+};
+
+class TextWriterFBX
+{
+public:
+	TextWriterFBX();
+	~TextWriterFBX();
+
+	/// \brief Open file for writing
+	/// \param fileName output path (without compression extension)
+	/// \param mode compression of the output stream
+	/// \param level compression level (< 0 uses the compressor's default)
+	bool open(const char* fileName,
+			  const TextCompression mode = TextCompression::NONE,
+			  const int level = -1);
+	/// \brief Flush remaining data and close file
+	void close();
+	/// \brief Total bytes written (including buffered data, uncompressed)
+	inline uint64_t bytesWritten() const { return m_written + m_used; }
+	/// \brief Bytes that reached the file (valid after close)
+	inline uint64_t fileBytes() const { return m_fileBytes; }
+	/// \brief A write to the file failed, output is incomplete (valid after
+	/// close)
+	inline bool failed() const { return m_failed; }
+
+	/// \brief Check if this build can write the compression mode
+	static bool supports(const TextCompression mode);
+	/// \brief File extension appended for the compression mode
+	static const char* extension(const TextCompression mode);
+
+	void put(const char* str);
+	void put(const char c);
+	void putUint(uint64_t val);
+	/// \brief Same text as printf("%.3f", val)
+	void putFloat(const float val);
+
+	/// \brief "tag a b ...\n" lines w/ "%.3f" floats
+	void floatLine(const char* tag, const float a);
+	void floatLine(const char* tag, const float a, const float b);
+	void floatLine(const char* tag, const float a, const float b, const float c);
+	void floatLine(const char* tag, const float a, const float b, const float c,
+				   const float d);
+	/// \brief "tag a b ...\n" lines w/ unsigned integers
+	void uintLine(const char* tag, const uint64_t a);
+	void uintLine(const char* tag, const uint64_t a, const uint64_t b,
+				  const uint64_t c);
+	void uintLine(const char* tag, const uint64_t a, const uint64_t b,
+				  const uint64_t c, const uint64_t d);
+
+private:
+	/// \brief Make room for at least size bytes in the buffer
+	inline void reserve(const size_t size)
+	{
+		if (m_used + size > TEXT_WRITER_BUFFER_SIZE) {
+			flush();
+		}
+	}
+	void flush();
+	/// \brief Write chunk to file (through the compressor if one is active)
+	void writeChunk(const char* data, const size_t size, const bool finish);
+	/// \brief fwrite w/ short writes reported (once)
+	void writeOut(const void* data, const size_t size);
+	/// \brief Background compression loop
+	void compressLoop();
+
+	FILE*			m_file;
+	dd_array<char>	m_buffers[2];	// one filling, one compressing
+	char*			m_data;			// buffer being filled
+	unsigned		m_fill;
+	size_t			m_used;
+	uint64_t		m_written;
+	uint64_t		m_fileBytes;
+
+	// compression
+	TextCompression			m_mode;
+	void*					m_stream;	// z_stream or ZSTD_CCtx
+	dd_array<char>			m_out;
+	std::thread				m_worker;
+	std::mutex				m_mutex;
+	std::condition_variable	m_cond;
+	const char*				m_pending;
+	size_t					m_pendingSize;
+	bool					m_hasPending;
+	bool					m_finish;
+	bool					m_failed;		// set by the writing thread
+
+	TextWriterFBX(const TextWriterFBX&);
+	TextWriterFBX& operator=(const TextWriterFBX&);
+};
@@ -28,7 +28,10 @@
 #ifndef pow2_core_Assert_h
 #define pow2_core_Assert_h
 
+// builds can compile the asserts out w/ -DPOW2_ASSERTS_DISABLED
+#ifndef POW2_ASSERTS_DISABLED
 #define POW2_ASSERTS_ENABLED
+#endif // POW2_ASSERTS_DISABLED
 
 namespace pow2 {
 	namespace Assert {
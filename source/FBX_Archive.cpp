@@ -0,0 +1,184 @@
+#include "FBX_Archive.h"
+#include <cstdio>
+#include <cstring>
+#ifdef DD_USE_ZLIB
+#include <zlib.h>
+#endif // DD_USE_ZLIB
+
+#define ZIP_EOCD_SIG 0x06054b50
+#define ZIP_CDIR_SIG 0x02014b50
+#define ZIP_LOCAL_SIG 0x04034b50
+#define ZIP_EOCD_SIZE 22
+#define ZIP_CDIR_SIZE 46
+#define ZIP_LOCAL_SIZE 30
+
+namespace {
+
+// zip records are little-endian and unaligned
+uint16_t readU16(const char* ptr)
+{
+	const uint8_t* b = (const uint8_t*)ptr;
+	return (uint16_t)(b[0] | (b[1] << 8));
+}
+
+uint32_t readU32(const char* ptr)
+{
+	const uint8_t* b = (const uint8_t*)ptr;
+	return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) |
+		((uint32_t)b[3] << 24);
+}
+
+} // namespace
+
+bool ZipArchiveFBX::open(const char* fileName)
+{
+	m_entries.clear();
+	if (!m_file.mapFile(fileName) || m_file.size() < ZIP_EOCD_SIZE) {
+		printf("Could not open archive %s\n", fileName);
+		return false;
+	}
+	const char* data = m_file.data();
+	const size_t size = m_file.size();
+
+	// end of central directory sits at the end behind an optional comment
+	const size_t max_comment = 0xFFFF;
+	const size_t search_end =
+		(size - ZIP_EOCD_SIZE > max_comment) ? size - ZIP_EOCD_SIZE - max_comment
+											 : 0;
+	const char* eocd = nullptr;
+	for (size_t i = size - ZIP_EOCD_SIZE + 1; i-- > search_end;) {
+		if (readU32(data + i) == ZIP_EOCD_SIG) {
+			eocd = data + i;
+			break;
+		}
+	}
+	if (!eocd) {
+		printf("%s is not a zip archive\n", fileName);
+		return false;
+	}
+
+	const uint16_t num_entries = readU16(eocd + 10);
+	const uint64_t cdir_offset = readU32(eocd + 16);
+	if (cdir_offset == 0xFFFFFFFF) {
+		printf("%s: zip64 archives are not supported\n", fileName);
+		return false;
+	}
+
+	uint64_t offset = cdir_offset;
+	for (uint16_t i = 0; i < num_entries; i++) {
+		if (offset + ZIP_CDIR_SIZE > size ||
+			readU32(data + offset) != ZIP_CDIR_SIG) {
+			printf("%s: corrupt central directory\n", fileName);
+			return false;
+		}
+		const char* rec = data + offset;
+		const uint16_t flags = readU16(rec + 8);
+		const uint16_t name_len = readU16(rec + 28);
+		const uint16_t extra_len = readU16(rec + 30);
+		const uint16_t comment_len = readU16(rec + 32);
+		if (offset + ZIP_CDIR_SIZE + name_len > size) {
+			printf("%s: corrupt central directory\n", fileName);
+			return false;
+		}
+
+		ZipEntryFBX entry;
+		entry.name.assign(rec + ZIP_CDIR_SIZE, name_len);
+		entry.method = readU16(rec + 10);
+		entry.crc = readU32(rec + 16);
+		entry.comp_size = readU32(rec + 20);
+		entry.size = readU32(rec + 24);
+		entry.header_offset = readU32(rec + 42);
+		offset += ZIP_CDIR_SIZE + name_len + extra_len + comment_len;
+
+		// skip directories, encrypted and zip64 entries
+		if (entry.name.empty() || entry.name.back() == '/') {
+			continue;
+		}
+		if ((flags & 0x1) || entry.size == 0xFFFFFFFF ||
+			entry.comp_size == 0xFFFFFFFF) {
+			printf("%s: skipping unsupported entry %s\n", fileName,
+				   entry.name.c_str());
+			continue;
+		}
+		m_entries.push_back(entry);
+	}
+	return true;
+}
+
+bool ZipArchiveFBX::extract(const ZipEntryFBX& entry,
+							dd_array<char>& buffer) const
+{
+	const char* data = m_file.data();
+	const size_t size = m_file.size();
+	const uint64_t local = entry.header_offset;
+	if (local + ZIP_LOCAL_SIZE > size || readU32(data + local) != ZIP_LOCAL_SIG) {
+		printf("Corrupt local header: %s\n", entry.name.c_str());
+		return false;
+	}
+	// local name/extra lengths can differ from the central directory copy
+	const uint64_t start = local + ZIP_LOCAL_SIZE + readU16(data + local + 26) +
+		readU16(data + local + 28);
+	if (start + entry.comp_size > size) {
+		printf("Truncated entry: %s\n", entry.name.c_str());
+		return false;
+	}
+	// stored data is copied as-is, so both sizes must agree
+	if (entry.method == 0 && entry.size != entry.comp_size) {
+		printf("Corrupt stored entry: %s\n", entry.name.c_str());
+		return false;
+	}
+
+	buffer.resizeUninit(entry.size);	// filled by memcpy or inflate
+	if (entry.size == 0) {
+		return true;
+	}
+	if (entry.method == 0) {
+		memcpy(&buffer[0], data + start, entry.size);
+	}
+	else if (entry.method == 8) {
+#ifdef DD_USE_ZLIB
+		z_stream zs;
+		memset(&zs, 0, sizeof(z_stream));
+		if (inflateInit2(&zs, -MAX_WBITS) != Z_OK) { // raw deflate
+			return false;
+		}
+		zs.next_in = (Bytef*)(data + start);
+		zs.avail_in = (uInt)entry.comp_size;
+		zs.next_out = (Bytef*)&buffer[0];
+		zs.avail_out = (uInt)entry.size;
+		const int result = inflate(&zs, Z_FINISH);
+		inflateEnd(&zs);
+		if (result != Z_STREAM_END || zs.total_out != entry.size) {
+			printf("Inflate failed: %s\n", entry.name.c_str());
+			return false;
+		}
+#else
+		printf("Built without zlib, cannot inflate %s\n", entry.name.c_str());
+		return false;
+#endif // DD_USE_ZLIB
+	}
+	else {
+		printf("Unsupported compression (%u): %s\n", entry.method,
+			   entry.name.c_str());
+		return false;
+	}
+
+#ifdef DD_USE_ZLIB
+	const uLong crc = crc32(0L, (const Bytef*)&buffer[0], (uInt)entry.size);
+	if (crc != entry.crc) {
+		printf("CRC mismatch: %s\n", entry.name.c_str());
+		return false;
+	}
+#endif // DD_USE_ZLIB
+	return true;
+}
+
+const ZipEntryFBX* ZipArchiveFBX::find(const std::string& name) const
+{
+	for (auto& entry : m_entries) {
+		if (entry.name == name) {
+			return &entry;
+		}
+	}
+	return nullptr;
+}
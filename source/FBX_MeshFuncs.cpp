@@ -1,6 +1,10 @@
 #include "FBX_MeshFuncs.h"
 #include <vector>
 #include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
 
 enum class CurveArgs { TRANS, ROT, SCALE, X_, Y_, Z_ };
 
@@ -9,14 +13,19 @@ dd_array<vec2_f> DisplayCurve(FbxAnimCurve* pCurve);
 /// \brief Process asset and export file w/ mesh and animation data
 /// \param node FbxNode with mesh and anim information
 void processAsset(FbxNode* node, AssetFBX& _asset, bool export_skeleton,
-                  bool export_mesh) {
+                  bool export_mesh, bool export_mesh_bin,
+                  bool export_skeleton_bin) {
   const char* nodeName = node->GetName();
 
   // create new mesh w/ id
   MeshFBX mesh(nodeName);
 
   FbxMesh* currmesh = (FbxMesh*)node->GetMesh();
-  mesh.m_ctrlpnts.resize(currmesh->GetControlPointsCount());
+  // skeleton only runs just read the bind pose off the skin clusters
+  const bool build_mesh = export_mesh || export_mesh_bin;
+  if (build_mesh) {
+    mesh.m_ctrlpnts.resize(currmesh->GetControlPointsCount());
+  }
 
   // get vertex positions
   for (size_t i = 0; i < mesh.m_ctrlpnts.size(); i++) {
@@ -29,29 +38,59 @@ void processAsset(FbxNode* node, AssetFBX& _asset, bool export_skeleton,
         static_cast<float>(currmesh->GetControlPointAt((int)i).mData[2]);
   }
 
-  // get skeleton blend information
-  processSkeleton(currmesh, mesh, _asset.m_skeleton);
-  // get mesh buffers
-  processMesh(node, mesh);
-  // get all materials
-  _asset.m_matbin = processMats(node);
-  // tag and construct ebo buffers
-  dd_array<size_t> ebos =
-      connectMatToMesh(node, mesh, (uint8_t)_asset.m_matbin.size());
-  // finalize asset
-  _asset.addMesh(mesh, ebos);
+  // get skeleton blend information (no weights w/o control points)
+  std::vector<SkinInfluence> influences;
+  processSkeleton(currmesh, mesh, _asset.m_skeleton, influences);
+  if (build_mesh) {
+    resolveSkinWeights(mesh, influences, _asset.m_maxInfluences,
+                       _asset.m_weightBits);
+    // get mesh buffers
+    processMesh(node, mesh);
+    processBlendShapes(currmesh, mesh, _asset.m_shapeEpsilon);
+    if (_asset.m_weldVerts) {
+      weldVerts(mesh, _asset.m_weldEpsilon);
+    }
+    // get all materials
+    _asset.m_matbin = processMats(node);
+    // tag and construct ebo buffers
+    dd_array<size_t> ebos =
+        connectMatToMesh(node, mesh, (uint8_t)_asset.m_matbin.size());
+    // finalize asset
+    _asset.addMesh(mesh, ebos);
+    if (_asset.m_optimizeCache) {
+      _asset.optimizeVertCache();
+    }
 
-  printf("Mesh name ='%s'(%lu)\n", mesh.m_id.str(), mesh.m_id.gethash());
+    printf("Mesh name ='%s'(%lu)\n", mesh.m_id.str(), mesh.m_id.gethash());
+  }
   if (export_mesh) {
     _asset.exportMesh();
   }
+  if (export_mesh_bin) {
+    _asset.exportMeshBinary();
+  }
   if (export_skeleton) {
     _asset.exportSkeleton();
   }
+  if (export_skeleton_bin) {
+    _asset.exportSkeletonBinary();
+  }
+}
+
+/// \brief Store matrix as the 3x4 row-major inverse bind layout (DDBInvBind)
+/// \param mat FbxAMatrix (column vectors, mData[3] holds the translation)
+/// \param out 12 floats, rows of the upper 3x4
+void storeInvBind(const FbxAMatrix& mat, float out[12]) {
+  for (int r = 0; r < 3; r++) {
+    for (int c = 0; c < 4; c++) {
+      out[r * 4 + c] = (float)mat.Get(c, r);
+    }
+  }
 }
 
 /// \brief Process node to get skeleton heirarchy
 /// \param _geom FbxNode with skeletal heirarchy information
+/// \param index parent joint (MAX_JOINTS: none, joints become roots)
 void processSkeletonAsset(FbxNode* node, const size_t index, AssetFBX& _asset) {
   bool recordbone = false;
   for (int i = 0; i < node->GetNodeAttributeCount(); i++) {
@@ -62,18 +101,27 @@ void processSkeletonAsset(FbxNode* node, const size_t index, AssetFBX& _asset) {
   }
   // skeleton joint/limb information
   SkelFbx& _sk = _asset.m_skeleton;
-  size_t next_parent = _sk.m_numJoints - 1;
+  // children of non-joint nodes (helpers, nulls) attach to the closest joint
+  size_t next_parent = index;
   printf("Checking: %s\n", (char*)node->GetName());
   if (recordbone) {
-    JointFBX& this_j = _sk.m_joints[_sk.m_numJoints];
-    this_j.m_name.set((char*)node->GetName());
-    this_j.m_idx = _sk.m_numJoints;
-    this_j.m_parent = index;
-    printf("Skeleton Name: %s (%u : %u)\n", this_j.m_name.str(), this_j.m_idx,
-           this_j.m_parent);
-    // increment joint counter and index of next parent
-    _sk.m_numJoints += 1;
-    next_parent += 1;
+    JointFBX* this_j = _sk.addJoint();
+    if (!this_j) {
+      printf("Skeleton exceeds %u joints, skipping: %s\n", (unsigned)MAX_JOINTS,
+             node->GetName());
+      return;
+    }
+    this_j->m_name.set((char*)node->GetName());
+    // a root is its own parent
+    this_j->m_parent =
+        (index == MAX_JOINTS) ? this_j->m_idx : (uint16_t)index;
+    // rest pose until a skin cluster supplies the bind pose
+    storeInvBind(node->EvaluateGlobalTransform().Inverse(), this_j->m_invBind);
+    _sk.indexJoint(node, this_j->m_idx);
+    printf("Skeleton Name: %s (%u : %u)\n", this_j->m_name.str(),
+           this_j->m_idx, this_j->m_parent);
+    // index of next parent
+    next_parent = this_j->m_idx;
   }
 
   // loop thru children nodes for skeleton
@@ -157,7 +205,8 @@ dd_array<vec2_f> getKeyFrames(FbxAnimCurve* animCurve,
   return output;
 }
 
-dd_array<vec2_f> getKeyFrames2(FbxAnimCurve* animCurve, const unsigned fps) {
+dd_scratch_array<vec2_f> getKeyFrames2(FbxAnimCurve* animCurve,
+                                       const unsigned fps) {
 	// get total time of animation and use to set limits
 	FbxTimeSpan curve_span;
 	const bool success = animCurve->GetTimeInterval(curve_span);
@@ -175,7 +224,7 @@ dd_array<vec2_f> getKeyFrames2(FbxAnimCurve* animCurve, const unsigned fps) {
 		num_frames += 1;
 	}
 
-	dd_array<vec2_f> output(num_frames);
+	dd_scratch_array<vec2_f> output(num_frames);
 	float key_val = 0.f;
 	FbxTime key_time(FBXSDK_TC_ZERO);
 	const FbxLongLong fbx_frametime = FBXSDK_TC_SECOND / fps;
@@ -202,6 +251,40 @@ dd_array<vec2_f> getKeyFrames2(FbxAnimCurve* animCurve, const unsigned fps) {
 	return output;
 }
 
+/// \brief Map sampled channel (0-2 rotation, 3-5 translation) to the stored
+/// channel (vicon fix swaps translation y/z)
+unsigned storedChannel(const unsigned channel, const bool vicon_fix) {
+  if (channel < 3 || !vicon_fix) {
+    return channel;
+  }
+  switch (channel) {
+    case 4:
+      return 5;
+    case 5:
+      return 4;
+    default:
+      return 3;
+  }
+}
+
+/// \brief Store one sampled channel (vicon fix also negates translation x)
+void writeChannel(AnimClipFBX& clip, const unsigned frame,
+                  const unsigned jnt_idx, const unsigned channel,
+                  const float value, const bool vicon_fix,
+                  const bool log = true) {
+  const unsigned stored = storedChannel(channel, vicon_fix);
+  const float val = (vicon_fix && channel == 3) ? -value : value;
+  AnimSample& sample = clip.sample(frame, jnt_idx);
+  if (stored < 3) {
+    sample.rot.data[stored] = val;
+  } else {
+    sample.pos.data[stored - 3] = val;
+  }
+  if (log) {
+    clip.setLogged(frame, jnt_idx, stored);
+  }
+}
+
 /// \brief Get animation curve data from fbx
 /// \param node FbxNode with animation information
 /// \param animstack FbxAnimLayer with animation information
@@ -209,11 +292,10 @@ dd_array<vec2_f> getKeyFrames2(FbxAnimCurve* animCurve, const unsigned fps) {
 void getCurveInfo(FbxNode* node, FbxAnimLayer* animlayer, AnimClipFBX& animclip,
                   const unsigned jnt_idx, bool vicon_fix = false) {
   FbxAnimCurve* lAnimCurve = NULL;
-  dd_array<vec2_f> frame_X, frame_Y, frame_Z;
 
   // set animations
   CurveArgs order[] = {CurveArgs::X_, CurveArgs::Y_, CurveArgs::Z_};
-  dd_array<vec2_f> bin[] = {frame_X, frame_Y, frame_Z};
+  dd_scratch_array<vec2_f> bin[3];
 
   for (auto& transform : {CurveArgs::ROT, CurveArgs::TRANS}) {
 		//// x axis
@@ -234,44 +316,18 @@ void getCurveInfo(FbxNode* node, FbxAnimLayer* animlayer, AnimClipFBX& animclip,
       if (lAnimCurve) {
 				//bin[idx] = getKeyFrames(lAnimCurve, lAnimCurve->KeyGetCount());
 				bin[idx] = getKeyFrames2(lAnimCurve, animclip.m_framerate);
+        // grow dense storage if the curve outlasts the stack's time span
+        animclip.reserveFrames((uint32_t)bin[idx].size());
+        const unsigned base = (transform == CurveArgs::ROT) ? 0 : 3;
+
         // fill in animation for particular axis
         for (unsigned i = 0; i < bin[idx].size(); i++) {
           unsigned frame_num = (unsigned)bin[idx][i].x();
-
-          // if clause should only execute once
-          if (animclip.m_clip.count(frame_num) == 0) {
-            animclip.m_clip[frame_num] = PoseSample();
-            animclip.m_clip[frame_num].pose.resize(animclip.m_joints);
-            animclip.m_clip[frame_num].logged_r.resize(animclip.m_joints);
-            animclip.m_clip[frame_num].logged_t.resize(animclip.m_joints);
-          }
-          // fill in dictionary of animations
-          dd_array<vec3_u>& log = (transform == CurveArgs::ROT)
-                                      ? animclip.m_clip[frame_num].logged_r
-                                      : animclip.m_clip[frame_num].logged_t;
-          vec3_f& trans = (transform == CurveArgs::ROT)
-                              ? animclip.m_clip[frame_num].pose[jnt_idx].rot
-                              : animclip.m_clip[frame_num].pose[jnt_idx].pos;
-
-          if (transform == CurveArgs::TRANS && vicon_fix) {
-            switch (idx) {
-              case 1:
-                trans.data[idx + 1] = bin[idx][i].y();
-                log[jnt_idx].data[idx + 1] = 1;
-                break;
-              case 2:
-                trans.data[idx - 1] = bin[idx][i].y();
-                log[jnt_idx].data[idx - 1] = 1;
-                break;
-              default:
-                trans.data[idx] = -bin[idx][i].y();
-                log[jnt_idx].data[idx] = 1;
-                break;
-            }
-          } else {
-            trans.data[idx] = bin[idx][i].y();
-            log[jnt_idx].data[idx] = 1;
-          }
+          writeChannel(animclip, frame_num, jnt_idx, base + idx,
+                       bin[idx][i].y(), vicon_fix);
+        }
+        if (bin[idx].size() > animclip.m_frames) {
+          animclip.m_frames = (uint32_t)bin[idx].size();
         }
       }
     }
@@ -288,16 +344,11 @@ void processAnimLayer(FbxNode* node, FbxAnimLayer* animlayer, AssetFBX& _asset,
   lOutputString = "     Node found: ";
   lOutputString += node->GetName();
 
-  cbuff<32> node_name;
-  node_name.set(node->GetName());
-  bool bone_found = false;
   // only save animations from skeleton
-  for (unsigned i = 0; i < _asset.m_skeleton.m_numJoints && !bone_found; i++) {
-    if (_asset.m_skeleton.m_joints[i].m_name == node_name) {
-      printf("%s\n", lOutputString.Buffer());
-      getCurveInfo(node, animlayer, clip, i, _asset.m_viconFormat);
-			bone_found = true;
-    }
+  const int jnt_idx = _asset.m_skeleton.findJoint(node);
+  if (jnt_idx >= 0) {
+    printf("%s\n", lOutputString.Buffer());
+    getCurveInfo(node, animlayer, clip, jnt_idx, _asset.m_viconFormat);
   }
 
   for (int i = 0; i < node->GetChildCount(); i++) {
@@ -305,65 +356,247 @@ void processAnimLayer(FbxNode* node, FbxAnimLayer* animlayer, AssetFBX& _asset,
   }
 }
 
-/// \brief Get animation data from fbx
-/// \param node FbxNode with animation information
-/// \param animstack FbxAnimStack with animation information
-/// \param _asset AssetFBX that holds to be exported data
-void processAnimation(FbxNode* node, FbxAnimStack* animstack, AssetFBX& _asset,
-                      const float framerate, const char* stack_name) {
-  /// \brief Fill in missing animations
-  auto fillIn = [&](std::map<unsigned, PoseSample> og_ps, const bool rotFlag,
-                    const unsigned jnt_idx) {
-    vec3_f last_saved = vec3_f(0, 0, 0);
-    unsigned last_log = 0;
-    PoseSample* ps = nullptr;
-
-    for (unsigned k = 0; k < og_ps.size(); k++) {
-      if (og_ps.count(k) > 0 && jnt_idx == 0) {
-        // initialize variable for saving position and checking logs
-        ps = &og_ps[k];
-        last_log = k;
-        dd_array<vec3_u>& check = og_ps[k].logged_t;
-        vec3_f& value = ps->pose[jnt_idx].pos;
-        if (rotFlag) {
-          check = og_ps[k].logged_r;
-          value = ps->pose[jnt_idx].rot;
-        }
+/// \brief Curves of one joint plus Evaluate() hints for frame-major sampling
+struct JointCurves {
+  FbxAnimCurve* curve[ANIM_CHANNELS];  // rot xyz, trans xyz
+  int last_key[ANIM_CHANNELS];
+  unsigned num_frames[ANIM_CHANNELS];
+  bool extra_frame[ANIM_CHANNELS];
+  unsigned jnt_idx;
+};
+
+/// \brief Number of frames baked from curve (same rule as getKeyFrames2)
+unsigned curveFrameCount(FbxAnimCurve* animCurve, const unsigned fps,
+                         bool& extra_frame) {
+  FbxTimeSpan curve_span;
+  animCurve->GetTimeInterval(curve_span);
+  const double curve_length = curve_span.GetDuration().GetSecondDouble();
+  unsigned num_frames = (unsigned)(curve_length / (1.0 / fps));
+
+  extra_frame = false;
+  if (animCurve->KeyGetCount() > (int)num_frames) {
+    extra_frame = true;
+    num_frames += 1;
+  }
+  return num_frames;
+}
+
+/// \brief Collect curves for every skeleton joint found under node
+void gatherJointCurves(FbxNode* node, FbxAnimLayer* animlayer,
+                       AssetFBX& _asset, const unsigned fps,
+                       std::vector<JointCurves>& joints) {
+  // only save animations from skeleton
+  const int jnt_idx = _asset.m_skeleton.findJoint(node);
+  if (jnt_idx >= 0) {
+    printf("     Node found: %s\n", node->GetName());
+    JointCurves jc;
+    jc.jnt_idx = jnt_idx;
+    const CurveArgs transforms[] = {CurveArgs::ROT, CurveArgs::TRANS};
+    const CurveArgs order[] = {CurveArgs::X_, CurveArgs::Y_, CurveArgs::Z_};
+    for (unsigned c = 0; c < ANIM_CHANNELS; c++) {
+      jc.curve[c] = getCurve(node, animlayer, transforms[c / 3], order[c % 3]);
+      jc.last_key[c] = 0;
+      jc.num_frames[c] = 0;
+      jc.extra_frame[c] = false;
+      if (jc.curve[c]) {
+        jc.num_frames[c] = curveFrameCount(jc.curve[c], fps, jc.extra_frame[c]);
+      }
+    }
+    joints.push_back(jc);
+  }
+
+  for (int i = 0; i < node->GetChildCount(); i++) {
+    gatherJointCurves(node->GetChild(i), animlayer, _asset, fps, joints);
+  }
+}
+
+/// \brief Sample an animation layer frame by frame: every joint's curves are
+/// evaluated at a frame before moving to the next one, reusing each curve's
+/// last key index so evaluation stays amortized O(1)
+/// \param node FbxNode at root of scene
+/// \param animlayer FbxAnimLayer with animation information
+/// \param _asset AssetFBX that holds skeleton information
+/// \param clip AnimClipFBX to fill (frame-major)
+void sampleAnimLayer(FbxNode* node, FbxAnimLayer* animlayer, AssetFBX& _asset,
+                     AnimClipFBX& clip) {
+  const unsigned fps = (unsigned)clip.m_framerate;
+  std::vector<JointCurves> joints;
+  gatherJointCurves(node, animlayer, _asset, fps, joints);
+
+  unsigned num_frames = 0;
+  for (auto& jc : joints) {
+    for (unsigned c = 0; c < ANIM_CHANNELS; c++) {
+      num_frames = std::max(num_frames, jc.num_frames[c]);
+    }
+  }
+  clip.reserveFrames(num_frames);
+
+  const FbxLongLong fbx_frametime = FBXSDK_TC_SECOND / fps;
+  auto evalChannel = [&](JointCurves& jc, const unsigned c, const unsigned f) {
+    // remainder frame takes the last key directly
+    if (jc.extra_frame[c] && f == jc.num_frames[c] - 1) {
+      return static_cast<float>(jc.curve[c]->KeyGetValue(f));
+    }
+    return jc.curve[c]->Evaluate(FbxTime(fbx_frametime * f), &jc.last_key[c]);
+  };
 
-        // printf("\t%u : ", k);
-        // check if value was key framed. If not, copy last value
-        if (og_ps[k].logged_t[jnt_idx].x() == 1) {  // x axis
-          // printf("a(%.3f) ", value.x());
-          last_saved.x() = value.x();
-        } else {
-          // printf("F~(%.3f)~", last_saved.x());
-          value.x() = last_saved.x();
+  if (_asset.m_parallelSampling) {
+    // FbxAnimCurve::Evaluate is not documented as thread-safe, so every curve
+    // is baked to a plain array on this thread (same calls, same order per
+    // curve as the serial path). Only the scatter into the frame-major clip
+    // runs in parallel and it never touches the SDK
+    std::vector<size_t> baked_at(joints.size() * ANIM_CHANNELS);
+    size_t num_baked = 0;
+    for (size_t i = 0; i < joints.size(); i++) {
+      for (unsigned c = 0; c < ANIM_CHANNELS; c++) {
+        baked_at[i * ANIM_CHANNELS + c] = num_baked;
+        num_baked += joints[i].curve[c] ? joints[i].num_frames[c] : 0;
+      }
+    }
+    dd_scratch_array<float> baked(num_baked);
+    for (size_t i = 0; i < joints.size(); i++) {
+      for (unsigned c = 0; c < ANIM_CHANNELS; c++) {
+        if (!joints[i].curve[c]) {
+          continue;
         }
-        if (og_ps[k].logged_t[jnt_idx].y() == 1) {  // y axis
-          // printf("b(%.3f) ", value.y());
-          last_saved.y() = value.y();
-        } else {
-          // printf("F~(%.3f)~", last_saved.y());
-          value.y() = last_saved.y();
+        const size_t base = baked_at[i * ANIM_CHANNELS + c];
+        for (unsigned f = 0; f < joints[i].num_frames[c]; f++) {
+          baked[base + f] = evalChannel(joints[i], c, f);
+        }
+      }
+    }
+
+    // each joint (and every curve set mapped to it) is owned by one thread
+    std::vector<std::vector<size_t>> owned(clip.m_joints);
+    for (size_t i = 0; i < joints.size(); i++) {
+      owned[joints[i].jnt_idx].push_back(i);
+    }
+    const int num_joints = (int)owned.size();
+#pragma omp parallel for schedule(dynamic)
+    for (int j = 0; j < num_joints; j++) {
+      for (unsigned f = 0; f < num_frames; f++) {
+        for (const size_t i : owned[j]) {
+          for (unsigned c = 0; c < ANIM_CHANNELS; c++) {
+            if (joints[i].curve[c] && f < joints[i].num_frames[c]) {
+              writeChannel(clip, f, j, c,
+                           baked[baked_at[i * ANIM_CHANNELS + c] + f],
+                           _asset.m_viconFormat, false);
+            }
+          }
         }
-        if (og_ps[k].logged_t[jnt_idx].z() == 1) {  // z axis
-          // printf("c(%.3f) ", value.z());
-          last_saved.z() = value.z();
-        } else {
-          // printf("F~(%.3f)~", last_saved.z());
-          value.z() = last_saved.z();
+      }
+    }
+    // logged bits of neighboring joints share words: set them serially
+    for (auto& jc : joints) {
+      for (unsigned c = 0; c < ANIM_CHANNELS; c++) {
+        const unsigned stored = storedChannel(c, _asset.m_viconFormat);
+        for (unsigned f = 0; jc.curve[c] && f < jc.num_frames[c]; f++) {
+          clip.setLogged(f, jc.jnt_idx, stored);
         }
-        // printf("\n");
       }
-      // fill in completely missing frames with previous logged frame
-      else if (og_ps.count(k) == 0 && jnt_idx == 0 && ps) {
-        // printf("\t%u : skipped and set to %u\n", k, last_log);
-        og_ps[k] = PoseSample();
-        og_ps[k].pose = ps->pose;
+    }
+  } else {
+    for (unsigned f = 0; f < num_frames; f++) {
+      for (auto& jc : joints) {
+        for (unsigned c = 0; c < ANIM_CHANNELS; c++) {
+          if (jc.curve[c] && f < jc.num_frames[c]) {
+            writeChannel(clip, f, jc.jnt_idx, c, evalChannel(jc, c, f),
+                         _asset.m_viconFormat);
+          }
+        }
       }
     }
+  }
+  clip.m_frames = std::max(clip.m_frames, (uint32_t)num_frames);
+}
+
+/// \brief Error-bounded keyframe reduction. Each joint keeps the fewest frames
+/// (greedy, first & last always kept) such that linear interpolation between
+/// kept frames reproduces every dropped frame within tolerance on all channels
+/// \param clip AnimClipFBX with sampled frames (m_keys is filled)
+/// \param pos_tol max position error (exported units, i.e. after scale)
+/// \param rot_tol max rotation error (degrees)
+/// \param scale_factor export scale applied to positions
+void reduceKeyframes(AnimClipFBX& clip, const float pos_tol,
+                     const float rot_tol, const float scale_factor) {
+  const float min_tol = 1e-5f;  // absorb float noise on exactly linear data
+  double tol[ANIM_CHANNELS];
+  for (unsigned c = 0; c < ANIM_CHANNELS; c++) {
+    tol[c] = (c < 3) ? std::max(rot_tol, min_tol)
+                     : std::max(pos_tol, min_tol) / scale_factor;
+  }
+  auto value = [&](const uint32_t f, const uint32_t j, const unsigned c) {
+    const AnimSample& s = clip.sample(f, j);
+    return (double)((c < 3) ? s.rot.data[c] : s.pos.data[c - 3]);
   };
 
+  std::vector<uint32_t> keys;
+  keys.reserve(clip.m_frames);
+  clip.m_keyOffsets.resize(clip.m_joints + 1);
+  clip.m_keyOffsets[0] = 0;
+
+  for (uint32_t j = 0; j < clip.m_joints; j++) {
+    if (clip.m_frames > 0) {
+      uint32_t anchor = 0;
+      keys.push_back(anchor);
+      // feasible slope range from anchor (constraints of interior frames)
+      double lo[ANIM_CHANNELS], hi[ANIM_CHANNELS];
+      auto resetSlopes = [&]() {
+        for (unsigned c = 0; c < ANIM_CHANNELS; c++) {
+          lo[c] = -HUGE_VAL;
+          hi[c] = HUGE_VAL;
+        }
+      };
+      resetSlopes();
+
+      for (uint32_t f = 1; f < clip.m_frames; f++) {
+        bool fits = true;
+        double dt = (double)(f - anchor);
+        for (unsigned c = 0; c < ANIM_CHANNELS && fits; c++) {
+          const double slope = (value(f, j, c) - value(anchor, j, c)) / dt;
+          fits = slope >= lo[c] && slope <= hi[c];
+        }
+        if (!fits) {
+          // previous frame ends the segment and anchors the next one
+          anchor = f - 1;
+          keys.push_back(anchor);
+          resetSlopes();
+          dt = 1.0;
+        }
+        // frame f becomes an interior point of the growing segment
+        for (unsigned c = 0; c < ANIM_CHANNELS; c++) {
+          const double delta = value(f, j, c) - value(anchor, j, c);
+          lo[c] = std::max(lo[c], (delta - tol[c]) / dt);
+          hi[c] = std::min(hi[c], (delta + tol[c]) / dt);
+        }
+      }
+      if (anchor != clip.m_frames - 1) {
+        keys.push_back(clip.m_frames - 1);
+      }
+    }
+    clip.m_keyOffsets[j + 1] = (uint32_t)keys.size();
+  }
+
+  clip.m_keys.resize(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    clip.m_keys[i] = keys[i];
+  }
+  const size_t dense = (size_t)clip.m_frames * clip.m_joints;
+  printf("Keyframe reduction: %lu samples -> %lu keys (%.2fx)\n", dense,
+         keys.size(), keys.empty() ? 0.f : (float)dense / keys.size());
+}
+
+/// \brief Get animation data from fbx
+/// \param node FbxNode with animation information
+/// \param animstack FbxAnimStack with animation information
+/// \param _asset AssetFBX that holds to be exported data
+void processAnimation(FbxNode* node, FbxAnimStack* animstack, AssetFBX& _asset,
+                      const float framerate, const char* stack_name) {
+  // size clip storage once from the stack's time span
+  FbxTimeSpan stack_span = animstack->GetLocalTimeSpan();
+  const uint32_t stack_frames =
+      (uint32_t)(stack_span.GetStop().GetSecondDouble() * framerate) + 1;
+
   int nbAnimLayers = animstack->GetMemberCount<FbxAnimLayer>();
   FbxString lOutputString;
   _asset.m_clips.resize(nbAnimLayers);
@@ -384,22 +617,102 @@ void processAnimation(FbxNode* node, FbxAnimStack* animstack, AssetFBX& _asset,
     _asset.m_clips[i].m_id.set(lOutputString.Buffer());
     _asset.m_clips[i].m_framerate = framerate;
     _asset.m_clips[i].m_joints = _asset.m_skeleton.m_numJoints;
-    processAnimLayer(node, lAnimLayer, _asset, _asset.m_clips[i]);
+    _asset.m_clips[i].reserveFrames(stack_frames);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    if (_asset.m_curveSampler) {
+      processAnimLayer(node, lAnimLayer, _asset, _asset.m_clips[i]);
+    } else {
+      sampleAnimLayer(node, lAnimLayer, _asset, _asset.m_clips[i]);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    printf("Sampled %u joints x %u frames in %.3f ms (%s)\n",
+           _asset.m_clips[i].m_joints, _asset.m_clips[i].m_frames,
+           std::chrono::duration<double, std::milli>(end - start).count(),
+           _asset.m_curveSampler
+               ? "per-curve"
+               : (_asset.m_parallelSampling ? "per-frame, parallel" : "per-frame"));
+
+    sampleShapeWeights(node, lAnimLayer, _asset.m_clips[i]);
+
+    if (_asset.m_posTolerance >= 0.f || _asset.m_rotTolerance >= 0.f) {
+      reduceKeyframes(_asset.m_clips[i], std::max(_asset.m_posTolerance, 0.f),
+                      std::max(_asset.m_rotTolerance, 0.f),
+                      _asset.scale_factor);
+    }
+  }
+}
+
+/// \brief Collect blend shape channels of every mesh below node
+void gatherShapeChannels(FbxNode* node,
+                         std::vector<FbxBlendShapeChannel*>& channels) {
+  FbxMesh* currmesh = node->GetMesh();
+  if (currmesh) {
+    const int num_deformers =
+        currmesh->GetDeformerCount(FbxDeformer::eBlendShape);
+    for (int i = 0; i < num_deformers; i++) {
+      FbxBlendShape* blend = (FbxBlendShape*)currmesh->GetDeformer(
+          i, FbxDeformer::eBlendShape);
+      for (int c = 0; c < blend->GetBlendShapeChannelCount(); c++) {
+        FbxBlendShapeChannel* channel = blend->GetBlendShapeChannel(c);
+        if (channel && channel->GetTargetShapeCount() > 0) {
+          channels.push_back(channel);
+        }
+      }
+    }
+  }
+  for (int i = 0; i < node->GetChildCount(); i++) {
+    gatherShapeChannels(node->GetChild(i), channels);
+  }
+}
 
-    for (unsigned j = 0; j < _asset.m_clips[i].m_joints; j++) {
-      // printf("%s\n", _asset.m_skeleton.m_joints[j].m_name.str());
-      // fix issues with keyed animation
-      //fillIn(_asset.m_clips[i].m_clip, false, j);
-      //fillIn(_asset.m_clips[i].m_clip, true, j);
+/// \brief Sample blend shape weights (0-1) of an animation layer for every
+/// frame of the clip
+/// \param node FbxNode at root of scene
+/// \param animlayer FbxAnimLayer with DeformPercent curves
+/// \param clip AnimClipFBX to fill (m_frames must already be set)
+void sampleShapeWeights(FbxNode* node, FbxAnimLayer* animlayer,
+                        AnimClipFBX& clip) {
+  std::vector<FbxBlendShapeChannel*> channels;
+  gatherShapeChannels(node, channels);
+  clip.m_numShapes = (uint32_t)channels.size();
+  if (channels.empty()) {
+    return;
+  }
+  clip.m_shapeIds.resize(channels.size());
+  clip.m_shapeWeights.resize(channels.size() * clip.m_frames);
+
+  const FbxLongLong fbx_frametime =
+      FBXSDK_TC_SECOND / (unsigned)clip.m_framerate;
+  unsigned animated = 0;
+  for (size_t s = 0; s < channels.size(); s++) {
+    FbxBlendShapeChannel* channel = channels[s];
+    clip.m_shapeIds[s].set(channel->GetName());
+    float* weights = &clip.m_shapeWeights[s * clip.m_frames];
+    FbxAnimCurve* curve = channel->DeformPercent.GetCurve(animlayer);
+    if (curve) {
+      animated += 1;
+      int last_key = 0;
+      for (uint32_t f = 0; f < clip.m_frames; f++) {
+        weights[f] =
+            curve->Evaluate(FbxTime(fbx_frametime * f), &last_key) * 0.01f;
+      }
+    } else {
+      const float weight = (float)channel->DeformPercent.Get() * 0.01f;
+      std::fill(weights, weights + clip.m_frames, weight);
     }
   }
+  printf("Sampled %u blend shape weights (%u animated) x %u frames\n",
+         clip.m_numShapes, animated, clip.m_frames);
 }
 
 /// \brief Process node to get skeleton structure with tranforms
 /// \param _geom FbxNode with geometry and cluster information
 /// \param mesh MeshFBX mesh for modifing CtrlPnt data
 /// \param _sk SkelFBX skeleton for indexing joints
-void processSkeleton(FbxGeometry* _geom, MeshFBX& mesh, SkelFbx& _sk) {
+/// \param influences scratch pool that receives every cluster weight
+void processSkeleton(FbxGeometry* _geom, MeshFBX& mesh, SkelFbx& _sk,
+                     std::vector<SkinInfluence>& influences) {
   int lSkinCount = 0;
   int lClusterCount = 0;
   FbxCluster* lCluster;
@@ -434,18 +747,14 @@ void processSkeleton(FbxGeometry* _geom, MeshFBX& mesh, SkelFbx& _sk) {
       const char* lClusterModes[] = {"Normalize", "Additive", "Total1"};
       //printf("    Mode: %s\n", lClusterModes[lCluster->GetLinkMode()]);
 
-      // get name (and joint index)
-      std::string clustername = (char*)lCluster->GetLink()->GetName();
-      int j_idx = -1;
-      for (size_t k = 0; k < _sk.m_numJoints; k++) {
-        std::string id = _sk.m_joints[k].m_name.str();
-        if (id == clustername) {
-          j_idx = _sk.m_joints[k].m_idx;
-          break;
-        }
+      // get joint index of linked node
+      if (lCluster->GetLink() == NULL) {
+        continue;
       }
-      if (lCluster->GetLink() != NULL) {
-        //printf("        Name: %s (%d)\n", clustername.c_str(), j_idx);
+      const int j_idx = _sk.findJoint(lCluster->GetLink());
+      //printf("        Name: %s (%d)\n", lCluster->GetLink()->GetName(), j_idx);
+      if (j_idx < 0) {
+        continue;
       }
 
       // get matrices
@@ -470,46 +779,163 @@ void processSkeleton(FbxGeometry* _geom, MeshFBX& mesh, SkelFbx& _sk) {
 
         joint_to_world = false;
       }
+      // inverse bind: mesh space at bind time -> joint space
+      {
+        FbxAMatrix mesh_bind;
+        FbxAMatrix link_bind;
+        lCluster->GetTransformMatrix(mesh_bind);
+        lCluster->GetTransformLinkMatrix(link_bind);
+        storeInvBind(link_bind.Inverse() * mesh_bind,
+                     _sk.m_joints[j_idx].m_invBind);
+      }
       lMatrix = lCluster->GetTransformLinkMatrix(lMatrix);
       // printf("%s\n", matrixToStr(lMatrix).c_str());
       FbxVector4 pValue2 = lMatrix.GetT();
       _sk.m_joints[j_idx].m_lspos =
           vec3_f(pValue2.mData[0], pValue2.mData[1], pValue2.mData[2]);
-      //printvec3f(_sk.m_joints[j_idx].m_lspos, clustername.c_str());
+      //printvec3f(_sk.m_joints[j_idx].m_lspos, "local");
 
       pValue2 = lMatrix.GetR();
       _sk.m_joints[j_idx].m_lsrot =
           vec3_f(pValue2.mData[0], pValue2.mData[1], pValue2.mData[2]);
-      //printvec3f(_sk.m_joints[j_idx].m_lsrot, clustername.c_str());
+      //printvec3f(_sk.m_joints[j_idx].m_lsrot, "local");
 
       pValue2 = lMatrix.GetS();
       _sk.m_joints[j_idx].m_lsscl =
           vec3_f(pValue2.mData[0], pValue2.mData[1], pValue2.mData[2]);
-      //printvec3f(_sk.m_joints[j_idx].m_lsscl, clustername.c_str());
+      //printvec3f(_sk.m_joints[j_idx].m_lsscl, "local");
 
       // get control point blending weights and joint indices
-      std::string lString1 = "        Link Indices: ";
-      std::string lString2 = "        Weight Values: ";
       int lIndexCount = lCluster->GetControlPointIndicesCount();
       int* jnts = lCluster->GetControlPointIndices();
       double* weights = lCluster->GetControlPointWeights();
 
       // assign ctrl point weight
       for (size_t k = 0; k < (size_t)lIndexCount; k++) {
-        lString1 += std::to_string(jnts[k]);
-        lString2 += std::to_string((float)weights[k]);
-        mesh.m_ctrlpnts[jnts[k]].addBWPair(j_idx, (float)weights[k]);
-        if (k < (size_t)lIndexCount - 1) {
-          lString1 += ", ";
-          lString2 += ", ";
+        if (jnts[k] >= 0 && (size_t)jnts[k] < mesh.m_ctrlpnts.size() &&
+            weights[k] > 0.0) {
+          influences.push_back(
+              {(uint32_t)jnts[k], (uint16_t)j_idx, (float)weights[k]});
         }
       }
-      // printf("%s\n", lString1.c_str());
-      // printf("%s\n", lString2.c_str());
     }
   }
 }
 
+/// \brief Select the heaviest skin weights of every control point
+/// \param mesh MeshFBX mesh whose CtrlPnt joints/blends are written
+/// \param influences cluster weights gathered by processSkeleton
+/// \param max_influences weights kept per control point (top-k)
+/// \param weight_bits snap weights to n-bit unorm steps (0 is off)
+/// \return largest (normalized) weight that was dropped
+float resolveSkinWeights(MeshFBX& mesh,
+                         const std::vector<SkinInfluence>& influences,
+                         const unsigned max_influences,
+                         const unsigned weight_bits) {
+  const size_t num_cp = mesh.m_ctrlpnts.size();
+  const unsigned k_max =
+      std::min(std::max(max_influences, 1u), (unsigned)MAX_INFLUENCES);
+  if (influences.empty() || num_cp == 0) {
+    return 0.f;
+  }
+
+  // bucket influences by control point (counting sort into one packed pool)
+  dd_scratch_array<uint32_t> offsets(num_cp + 1);
+  for (const SkinInfluence& inf : influences) {
+    offsets[inf.m_ctrlpnt + 1] += 1;
+  }
+  for (size_t i = 0; i < num_cp; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+  dd_scratch_array<SkinInfluence> pool(influences.size());
+  {
+    dd_scratch_array<uint32_t> fill(num_cp);
+    std::copy(&offsets[0], &offsets[0] + num_cp, &fill[0]);
+    for (const SkinInfluence& inf : influences) {
+      pool[fill[inf.m_ctrlpnt]++] = inf;
+    }
+  }
+
+  const uint32_t max_q = weight_bits ? (1u << weight_bits) - 1 : 0;
+  float max_dropped = 0.f;
+  size_t num_over = 0;
+  unsigned most = 0;
+  for (size_t i = 0; i < num_cp; i++) {
+    SkinInfluence* first = &pool[0] + offsets[i];
+    SkinInfluence* last = &pool[0] + offsets[i + 1];
+    if (first == last) {
+      continue;
+    }
+    // merge repeated joints (a joint bound by several skins)
+    std::sort(first, last, [](const SkinInfluence& a, const SkinInfluence& b) {
+      return a.m_joint < b.m_joint;
+    });
+    SkinInfluence* end = first;
+    for (SkinInfluence* it = first + 1; it != last; it++) {
+      if (it->m_joint == end->m_joint) {
+        end->m_weight += it->m_weight;
+      } else {
+        *(++end) = *it;
+      }
+    }
+    last = end + 1;
+
+    // heaviest first (ties keep the lower joint index)
+    const unsigned count = (unsigned)(last - first);
+    const unsigned k = std::min(count, k_max);
+    std::partial_sort(first, first + k, last,
+                      [](const SkinInfluence& a, const SkinInfluence& b) {
+                        return a.m_weight > b.m_weight ||
+                               (a.m_weight == b.m_weight &&
+                                a.m_joint < b.m_joint);
+                      });
+    float total = 0.f;
+    float kept = 0.f;
+    for (unsigned j = 0; j < count; j++) {
+      total += first[j].m_weight;
+      kept += (j < k) ? first[j].m_weight : 0.f;
+    }
+    if (count > k) {
+      num_over += 1;
+      for (unsigned j = k; j < count; j++) {
+        max_dropped = std::max(max_dropped, first[j].m_weight / total);
+      }
+    }
+    most = std::max(most, count);
+
+    // renormalize kept weights
+    CtrlPnt& cp = mesh.m_ctrlpnts[i];
+    for (unsigned j = 0; j < MAX_INFLUENCES; j++) {
+      cp.m_joint[j] = (j < k) ? first[j].m_joint : 0;
+      cp.m_blend[j] = (j < k) ? first[j].m_weight / kept : 0.f;
+    }
+    if (max_q) {
+      // unorm steps w/ the rounding error folded into the largest weight so
+      // the quantized weights still sum to exactly max_q
+      int64_t sum = 0;
+      uint32_t q[MAX_INFLUENCES];
+      for (unsigned j = 0; j < k; j++) {
+        q[j] = (uint32_t)(cp.m_blend[j] * max_q + 0.5f);
+        sum += q[j];
+      }
+      q[0] = (uint32_t)((int64_t)q[0] + (int64_t)max_q - sum);
+      for (unsigned j = 0; j < k; j++) {
+        cp.m_blend[j] = (float)q[j] / max_q;
+      }
+    }
+  }
+
+  printf("Skin weights: %u max influences, %lu/%lu control points over %u "
+         "(max dropped weight %.4f)",
+         most, (unsigned long)num_over, (unsigned long)num_cp, k_max,
+         max_dropped);
+  if (max_q) {
+    printf(", %u-bit unorm", weight_bits);
+  }
+  printf("\n");
+  return max_dropped;
+}
+
 /// \brief Process mesh node to in-engine mesh structure
 /// \param node FbxNode with mesh information
 /// \param mesh mesh structure
@@ -548,7 +974,7 @@ void processMesh(FbxNode* node, MeshFBX& mesh) {
                                               cp_idx, vert_idx, tang[j]);
       mesh.m_verts[vert_idx].m_tang = tang[j];
       // joints
-      mesh.m_verts[vert_idx].m_joint = vec4_u(currCtrlPnt.m_joint);
+      mesh.m_verts[vert_idx].m_joint = vec4_u16(currCtrlPnt.m_joint);
       // blends
       mesh.m_verts[vert_idx].m_jblend = vec4_f(currCtrlPnt.m_blend);
       /*
@@ -564,46 +990,242 @@ void processMesh(FbxNode* node, MeshFBX& mesh) {
   }
 }
 
+/// \brief Extract blend shape channels of a mesh as sparse vertex deltas
+/// (call after processMesh, indices address mesh.m_verts)
+/// \param currmesh FbxMesh with blend shape deformers
+/// \param mesh mesh structure (m_shapes is filled)
+/// \param epsilon deltas whose components are all within epsilon are dropped
+void processBlendShapes(FbxMesh* currmesh, MeshFBX& mesh,
+                        const float epsilon) {
+  std::vector<FbxBlendShapeChannel*> channels;
+  const int num_deformers = currmesh->GetDeformerCount(FbxDeformer::eBlendShape);
+  for (int i = 0; i < num_deformers; i++) {
+    FbxBlendShape* blend = (FbxBlendShape*)currmesh->GetDeformer(
+        i, FbxDeformer::eBlendShape);
+    for (int c = 0; c < blend->GetBlendShapeChannelCount(); c++) {
+      FbxBlendShapeChannel* channel = blend->GetBlendShapeChannel(c);
+      if (channel && channel->GetTargetShapeCount() > 0) {
+        channels.push_back(channel);
+      }
+    }
+  }
+  if (channels.empty()) {
+    return;
+  }
+
+  const size_t num_verts = mesh.m_verts.size();
+  const size_t num_cp = mesh.m_ctrlpnts.size();
+  auto moved = [&](const vec3_f& d) {
+    return std::fabs(d.x()) > epsilon || std::fabs(d.y()) > epsilon ||
+           std::fabs(d.z()) > epsilon;
+  };
+
+  mesh.m_shapes.resize(channels.size());
+  std::vector<uint32_t> indices;
+  std::vector<vec3_f> dpos;
+  std::vector<vec3_f> dnorm;
+  dd_scratch_array<vec3_f> cp_delta(num_cp);
+  size_t num_deltas = 0;
+  for (size_t s = 0; s < channels.size(); s++) {
+    // in-between targets are skipped: the full weight target is the last one
+    FbxBlendShapeChannel* channel = channels[s];
+    FbxShape* shape =
+        channel->GetTargetShape(channel->GetTargetShapeCount() - 1);
+    ShapeFBX& out = mesh.m_shapes[s];
+    out.m_id.set(channel->GetName());
+
+    const int shape_cps = shape->GetControlPointsCount();
+    const FbxVector4* shape_pos = shape->GetControlPoints();
+    for (size_t i = 0; i < num_cp; i++) {
+      if ((int)i < shape_cps) {
+        const vec3_f& base = mesh.m_ctrlpnts[i].m_pos;
+        cp_delta[i] = vec3_f((float)shape_pos[i].mData[0] - base.x(),
+                             (float)shape_pos[i].mData[1] - base.y(),
+                             (float)shape_pos[i].mData[2] - base.z());
+      } else {
+        cp_delta[i] = vec3_f(0, 0, 0);
+      }
+    }
+
+    // vertices are still one per polygon corner (v = tri * 3 + corner)
+    FbxGeometryElementNormal* shape_norms = shape->GetElementNormal();
+    indices.clear();
+    dpos.clear();
+    dnorm.clear();
+    for (size_t v = 0; v < num_verts; v++) {
+      const int cp_idx = currmesh->GetPolygonVertex((int)(v / 3), (int)(v % 3));
+      const vec3_f& d_pos = cp_delta[cp_idx];
+      vec3_f d_norm(0, 0, 0);
+      if (shape_norms) {
+        vec3_f norm;
+        getVertInfo<FbxGeometryElementNormal*>(shape_norms, cp_idx, v, norm);
+        const vec3_f& base = mesh.m_verts[v].m_norm;
+        d_norm = vec3_f(norm.x() - base.x(), norm.y() - base.y(),
+                        norm.z() - base.z());
+      }
+      if (moved(d_pos) || moved(d_norm)) {
+        indices.push_back((uint32_t)v);
+        dpos.push_back(d_pos);
+        dnorm.push_back(d_norm);
+      }
+    }
+    out.m_indices.resize(indices.size());
+    out.m_dpos.resize(indices.size());
+    out.m_dnorm.resize(indices.size());
+    if (!indices.empty()) {
+      std::copy(indices.begin(), indices.end(), &out.m_indices[0]);
+      std::copy(dpos.begin(), dpos.end(), &out.m_dpos[0]);
+      std::copy(dnorm.begin(), dnorm.end(), &out.m_dnorm[0]);
+    }
+    num_deltas += indices.size();
+  }
+  printf("Blend shapes: %lu channels, %lu deltas (%.2f%% of dense)\n",
+         (unsigned long)channels.size(), (unsigned long)num_deltas,
+         100.0 * num_deltas / std::max<size_t>(channels.size() * num_verts, 1));
+}
+
+/// \brief Vertex key used for welding (every VertPNTUV attribute and the
+/// vertex's blend shape deltas)
+struct WeldKey {
+  int64_t data[20];
+
+  bool operator==(const WeldKey& other) const {
+    return memcmp(data, other.data, sizeof(data)) == 0;
+  }
+};
+
+struct WeldKeyHash {
+  size_t operator()(const WeldKey& key) const {
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned i = 0; i < 20; i++) {
+      h = (h ^ (uint64_t)key.data[i]) * 1099511628211ull;
+    }
+    return (size_t)h;
+  }
+};
+
+/// \brief Collapse identical vertices and remap triangle indices
+/// \param mesh mesh structure (m_verts & m_triangles are rewritten)
+/// \param epsilon float attributes within the same epsilon sized cell are
+/// merged (<= 0 requires an exact match)
+void weldVerts(MeshFBX& mesh, const float epsilon) {
+  const size_t num_verts = mesh.m_verts.size();
+  if (num_verts == 0) {
+    return;
+  }
+  const float inv_eps = (epsilon > 0.f) ? 1.f / epsilon : 0.f;
+
+  // quantize floats to epsilon cells (or take exact bits, folding -0 to 0)
+  auto keyFloat = [&](const float val) -> int64_t {
+    if (inv_eps > 0.f) {
+      return (int64_t)std::floor((double)val * inv_eps + 0.5);
+    }
+    const float f = (val == 0.f) ? 0.f : val;
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(uint32_t));
+    return (int64_t)bits;
+  };
+
+  // vertices only merge when every blend shape moves them the same way
+  dd_scratch_array<uint64_t> shape_sig(mesh.m_shapes.size() > 0 ? num_verts
+                                                                 : 0);
+  for (size_t s = 0; s < mesh.m_shapes.size(); s++) {
+    const ShapeFBX& shape = mesh.m_shapes[s];
+    for (size_t e = 0; e < shape.m_indices.size(); e++) {
+      uint64_t& h = shape_sig[shape.m_indices[e]];
+      h = (h ^ (s + 1)) * 1099511628211ull;
+      for (unsigned j = 0; j < 3; j++) {
+        h = (h ^ (uint64_t)keyFloat(shape.m_dpos[e].data[j])) *
+            1099511628211ull;
+        h = (h ^ (uint64_t)keyFloat(shape.m_dnorm[e].data[j])) *
+            1099511628211ull;
+      }
+    }
+  }
+
+  std::unordered_map<WeldKey, uint32_t, WeldKeyHash> unique_verts;
+  unique_verts.reserve(num_verts);
+  dd_array<uint32_t> remap;
+  remap.resizeUninit(num_verts);
+  dd_scratch_array<VertPNTUV> welded;
+  welded.reserve(num_verts);
+  uint32_t num_unique = 0;
+
+  for (size_t i = 0; i < num_verts; i++) {
+    const VertPNTUV& v = mesh.m_verts[i];
+    WeldKey key;
+    unsigned k = 0;
+    for (unsigned j = 0; j < 3; j++) key.data[k++] = keyFloat(v.m_pos.data[j]);
+    for (unsigned j = 0; j < 3; j++) key.data[k++] = keyFloat(v.m_norm.data[j]);
+    for (unsigned j = 0; j < 3; j++) key.data[k++] = keyFloat(v.m_tang.data[j]);
+    for (unsigned j = 0; j < 2; j++) key.data[k++] = keyFloat(v.m_uv.data[j]);
+    for (unsigned j = 0; j < 4; j++) key.data[k++] = v.m_joint.data[j];
+    for (unsigned j = 0; j < 4; j++) key.data[k++] = keyFloat(v.m_jblend.data[j]);
+    key.data[k++] = shape_sig.isValid() ? (int64_t)shape_sig[i] : 0;
+
+    auto found = unique_verts.insert(std::make_pair(key, num_unique));
+    if (found.second) {
+      welded.push_back(v);
+      num_unique += 1;
+    }
+    remap[i] = found.first->second;
+  }
+
+  for (size_t i = 0; i < mesh.m_triangles.size(); i++) {
+    vec3_u& tri = mesh.m_triangles[i].m_indices;
+    tri.x() = remap[tri.x()];
+    tri.y() = remap[tri.y()];
+    tri.z() = remap[tri.z()];
+  }
+
+  mesh.m_verts.resizeUninit(num_unique);
+  std::copy(&welded[0], &welded[0] + num_unique, &mesh.m_verts[0]);
+  for (size_t s = 0; s < mesh.m_shapes.size(); s++) {
+    mesh.m_shapes[s].remap(remap);
+  }
+  printf("Welded verts: %lu -> %u (%.2fx)\n", num_verts, num_unique,
+         (float)num_verts / (float)num_unique);
+}
+
 /// \brief Process connect material index to mesh (per-triangle)
 /// \param node FbxNode with mesh information
 /// \param mesh mesh structure
 dd_array<size_t> connectMatToMesh(FbxNode* node, MeshFBX& mesh,
                                   const uint8_t num_mats) {
-  FbxLayerElementArrayTemplate<int>* mat_idxes;
+  FbxLayerElementArrayTemplate<int>* mat_idxes = nullptr;
   FbxGeometryElement::EMappingMode mat_mapmode = FbxGeometryElement::eNone;
   FbxMesh* currMesh = node->GetMesh();
-  // counts number of triangle per material (ebo buffer)
-  dd_array<size_t> tris_in_mat(num_mats);
+  // counts number of triangle per material (ebo buffer). Triangles w/o a
+  // valid material (no material layer, bad index, no materials) go to bin 0
+  dd_array<size_t> tris_in_mat(num_mats > 0 ? num_mats : 1);
 
   if (currMesh->GetElementMaterial()) {
     mat_idxes = &(currMesh->GetElementMaterial()->GetIndexArray());
     mat_mapmode = currMesh->GetElementMaterial()->GetMappingMode();
+    if ((mat_mapmode == FbxGeometryElement::eByPolygon &&
+         mat_idxes->GetCount() != (int)mesh.m_triangles.size()) ||
+        mat_idxes->GetCount() == 0) {
+      mat_mapmode = FbxGeometryElement::eNone;
+    }
+    else if (mat_mapmode != FbxGeometryElement::eByPolygon &&
+             mat_mapmode != FbxGeometryElement::eAllSame) {
+      fprintf(stderr, "FBX Mat::Error::Invalid mapping index\n");
+    }
+  }
 
-    if (mat_idxes) {
-      switch (mat_mapmode) {
-        case FbxGeometryElement::eByPolygon: {
-          if (mat_idxes->GetCount() == (int)mesh.m_triangles.size()) {
-            for (size_t i = 0; i < mesh.m_triangles.size(); ++i) {
-              size_t mat_idx = mat_idxes->GetAt(i);
-              mesh.m_triangles[i].m_mat_idx = mat_idx;
-              tris_in_mat[mat_idx] += 1;
-            }
-          }
-          break;
-        }
-        case FbxGeometryElement::eAllSame: {
-          unsigned int mat_idx = mat_idxes->GetAt(0);
-          for (unsigned int i = 0; i < mesh.m_triangles.size(); ++i) {
-            mesh.m_triangles[i].m_mat_idx = mat_idx;
-            tris_in_mat[0] += 1;
-          }
-          break;
-        }
-        default:
-          fprintf(stderr, "FBX Mat::Error::Invalid mapping index\n");
-          break;
-      }
+  for (size_t i = 0; i < mesh.m_triangles.size(); ++i) {
+    size_t mat_idx = 0;
+    if (mat_mapmode == FbxGeometryElement::eByPolygon) {
+      mat_idx = mat_idxes->GetAt(i);
+    }
+    else if (mat_mapmode == FbxGeometryElement::eAllSame) {
+      mat_idx = mat_idxes->GetAt(0);
+    }
+    if (mat_idx >= tris_in_mat.size()) {
+      mat_idx = 0;
     }
+    mesh.m_triangles[i].m_mat_idx = mat_idx;
+    tris_in_mat[mat_idx] += 1;
   }
   return tris_in_mat;
 }
@@ -0,0 +1,248 @@
+#include "FBX_Stream.h"
+#include <cstring>
+#include <algorithm>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif // _WIN32
+
+MemStreamFBX::MemStreamFBX() :
+	m_data(nullptr),
+	m_size(0),
+	m_pos(0),
+	m_state(eClosed),
+	m_readerId(-1),
+	m_mapped(false)
+#ifdef _WIN32
+	,
+	m_fileHandle(INVALID_HANDLE_VALUE),
+	m_mapHandle(nullptr)
+#endif // _WIN32
+{}
+
+MemStreamFBX::~MemStreamFBX()
+{
+	release();
+}
+
+bool MemStreamFBX::mapFile(const char* fileName)
+{
+	release();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr,
+							  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0,
+										nullptr);
+	if (!mapping) {
+		CloseHandle(file);
+		return false;
+	}
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	m_fileHandle = file;
+	m_mapHandle = mapping;
+	m_data = (const char*)view;
+	m_size = (size_t)file_size.QuadPart;
+#else
+	const int fd = open(fileName, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		close(fd);
+		return false;
+	}
+	void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE,
+					  fd, 0);
+	close(fd); // mapping keeps its own reference to the file
+	if (view == MAP_FAILED) {
+		return false;
+	}
+	// start read-ahead now so a prefetched file is resident by import time
+	posix_madvise(view, (size_t)info.st_size, POSIX_MADV_WILLNEED);
+	posix_madvise(view, (size_t)info.st_size, POSIX_MADV_SEQUENTIAL);
+	m_data = (const char*)view;
+	m_size = (size_t)info.st_size;
+#endif // _WIN32
+	m_mapped = true;
+	m_pos = 0;
+	return true;
+}
+
+void MemStreamFBX::prefetchFile(const char* fileName)
+{
+#ifdef _WIN32
+	(void)fileName; // mapFile's sequential scan hint covers this on windows
+#else
+	const int fd = open(fileName, O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+	// read-ahead is queued by the kernel and outlives the descriptor
+	posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+	close(fd);
+#endif // _WIN32
+}
+
+void MemStreamFBX::setBuffer(const void* data, const size_t size)
+{
+	release();
+	m_data = (const char*)data;
+	m_size = size;
+	m_pos = 0;
+}
+
+void MemStreamFBX::release()
+{
+	if (m_mapped) {
+#ifdef _WIN32
+		UnmapViewOfFile(m_data);
+		CloseHandle(m_mapHandle);
+		CloseHandle(m_fileHandle);
+		m_mapHandle = nullptr;
+		m_fileHandle = INVALID_HANDLE_VALUE;
+#else
+		munmap((void*)m_data, m_size);
+#endif // _WIN32
+	}
+	m_data = nullptr;
+	m_size = 0;
+	m_pos = 0;
+	m_mapped = false;
+	m_state = eClosed;
+}
+
+void MemStreamFBX::setReaderID(FbxManager* sdkManager)
+{
+	m_readerId =
+		sdkManager->GetIOPluginRegistry()->FindReaderIDByExtension("fbx");
+}
+
+FbxStream::EState MemStreamFBX::GetState()
+{
+	return m_state;
+}
+
+bool MemStreamFBX::Open(void* /*pStreamData*/)
+{
+	if (!isValid()) {
+		return false;
+	}
+	m_pos = 0;
+	m_state = eOpen;
+	return true;
+}
+
+bool MemStreamFBX::Close()
+{
+	// the source stays valid so the same stream can be opened again
+	m_pos = 0;
+	m_state = eClosed;
+	return true;
+}
+
+bool MemStreamFBX::Flush()
+{
+	return true;
+}
+
+int MemStreamFBX::Write(const void* /*pData*/, int /*pSize*/)
+{
+	return 0; // read only
+}
+
+int MemStreamFBX::Read(void* pData, int pSize) const
+{
+	if (pSize <= 0 || m_pos >= m_size) {
+		return 0;
+	}
+	const size_t count = std::min((size_t)pSize, m_size - m_pos);
+	memcpy(pData, m_data + m_pos, count);
+	m_pos += count;
+	return (int)count;
+}
+
+char* MemStreamFBX::ReadString(char* pBuffer,
+							   int pMaxSize,
+							   bool pStopAtFirstWhiteSpace)
+{
+	if (pMaxSize <= 0 || m_pos >= m_size) {
+		return nullptr;
+	}
+	// same contract as fgets: stop after newline (or whitespace) or when full
+	int count = 0;
+	while (count < pMaxSize - 1 && m_pos < m_size) {
+		const char c = m_data[m_pos++];
+		pBuffer[count++] = c;
+		if (c == '\n' || (pStopAtFirstWhiteSpace && (c == ' ' || c == '\t'))) {
+			break;
+		}
+	}
+	pBuffer[count] = '\0';
+	return pBuffer;
+}
+
+int MemStreamFBX::GetReaderID() const
+{
+	return m_readerId;
+}
+
+int MemStreamFBX::GetWriterID() const
+{
+	return -1;
+}
+
+void MemStreamFBX::Seek(const FbxInt64& pOffset,
+						const FbxFile::ESeekPos& pSeekPos)
+{
+	FbxInt64 base = 0;
+	switch (pSeekPos) {
+		case FbxFile::eCurrent:
+			base = (FbxInt64)m_pos;
+			break;
+		case FbxFile::eEnd:
+			base = (FbxInt64)m_size;
+			break;
+		default:
+			break;
+	}
+	const FbxInt64 pos = base + pOffset;
+	m_pos = (pos < 0) ? 0 : std::min((size_t)pos, m_size);
+}
+
+long MemStreamFBX::GetPosition() const
+{
+	return (long)m_pos;
+}
+
+void MemStreamFBX::SetPosition(long pPosition)
+{
+	m_pos = (pPosition < 0) ? 0 : std::min((size_t)pPosition, m_size);
+}
+
+int MemStreamFBX::GetError() const
+{
+	return 0;
+}
+
+void MemStreamFBX::ClearError()
+{
+}
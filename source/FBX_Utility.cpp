@@ -1,16 +1,63 @@
 #include "FBX_Utility.h"
+#include "DD_Binary.h"
+#include "FBX_Writer.h"
 #include <map>
 #include <fstream>
+#include <chrono>
+#include <cmath>
 
 size_t numTabs = 0;
 
+void ShapeFBX::remap(const dd_array<uint32_t> &new_idx)
+{
+	const size_t count = m_indices.size();
+	if (count == 0) {
+		return;
+	}
+	dd_scratch_array<uint32_t> order(count);
+	for (size_t i = 0; i < count; i++) {
+		order[i] = (uint32_t)i;
+	}
+	// stable so the first entry of a merged vertex wins
+	std::stable_sort(&order[0], &order[0] + count,
+					 [&](const uint32_t a, const uint32_t b) {
+						 return new_idx[m_indices[a]] < new_idx[m_indices[b]];
+					 });
+	size_t num_unique = 0;
+	for (size_t i = 0; i < count; i++) {
+		const uint32_t v = new_idx[m_indices[order[i]]];
+		if (num_unique == 0 || v != new_idx[m_indices[order[num_unique - 1]]]) {
+			order[num_unique++] = order[i];
+		}
+	}
+
+	dd_array<uint32_t> indices(num_unique);
+	dd_array<vec3_f> dpos(num_unique);
+	dd_array<vec3_f> dnorm(num_unique);
+	for (size_t i = 0; i < num_unique; i++) {
+		indices[i] = new_idx[m_indices[order[i]]];
+		dpos[i] = m_dpos[order[i]];
+		dnorm[i] = m_dnorm[order[i]];
+	}
+	m_indices = std::move(indices);
+	m_dpos = std::move(dpos);
+	m_dnorm = std::move(dnorm);
+}
+
 /// \brief Split mesh into subsequent EBO buffers based on shared materials
 /// \param _mesh MeshFBX struct that contains all mesh buffer data
 /// \param ebo_data Lists buffer sizes for each material (sorted by index)
 void AssetFBX::addMesh(MeshFBX & _mesh, dd_array<size_t> &ebo_data)
 {
-	m_id.set(_mesh.m_id.str());
+	m_id = _mesh.m_id;
 	m_verts = std::move(_mesh.m_verts);
+	m_shapes = std::move(_mesh.m_shapes);
+
+	// a mesh w/o materials keeps its triangles under one default material
+	if( m_matbin.size() == 0 && ebo_data.size() > 0 ) {
+		m_matbin.resize(1);
+		m_matbin[0] = MatFBX("default");
+	}
 
 	printf("Materials\n");
 	// resize ebo and material buffer (materials w/ no triangles are skipped)
@@ -50,266 +97,1261 @@ void AssetFBX::addMesh(MeshFBX & _mesh, dd_array<size_t> &ebo_data)
 	}
 }
 
+#define VCACHE_SIZE 32
+#define VCACHE_SIM_SIZE 16
+
+/// \brief Average cache miss ratio (transforms per triangle) and average
+/// transform to vertex ratio of a triangle list run thru a FIFO cache
+static void vertCacheStats(const dd_array<vec3_u> &tris, const size_t num_verts,
+						   float &acmr, float &atvr)
+{
+	acmr = atvr = 0.f;
+	if (tris.size() == 0) {
+		return;
+	}
+	uint32_t fifo[VCACHE_SIM_SIZE];
+	unsigned head = 0, filled = 0;
+	size_t misses = 0;
+	dd_array<uint8_t> used(num_verts);
+	size_t num_used = 0;
+
+	for (size_t i = 0; i < tris.size(); i++) {
+		for (unsigned j = 0; j < 3; j++) {
+			const uint32_t v = tris[i].data[j];
+			bool hit = false;
+			for (unsigned k = 0; k < filled && !hit; k++) {
+				hit = (fifo[k] == v);
+			}
+			if (!hit) {
+				misses += 1;
+				fifo[head] = v;
+				head = (head + 1) % VCACHE_SIM_SIZE;
+				filled = (filled < VCACHE_SIM_SIZE) ? filled + 1 : filled;
+			}
+			if (!used[v]) {
+				used[v] = 1;
+				num_used += 1;
+			}
+		}
+	}
+	acmr = (float)misses / (float)tris.size();
+	atvr = (float)misses / (float)num_used;
+}
+
+/// \brief Forsyth "linear-speed vertex cache optimisation" triangle ordering
+static void forsythReorder(dd_array<vec3_u> &tris, const size_t num_verts)
+{
+	const size_t num_tris = tris.size();
+	if (num_tris == 0) {
+		return;
+	}
+	// score tables (cache position & remaining valence)
+	const float cache_decay = 1.5f;
+	const float last_tri_score = 0.75f;
+	const float valence_scale = 2.f;
+	const float valence_power = 0.5f;
+	float pos_score[VCACHE_SIZE];
+	for (unsigned i = 0; i < VCACHE_SIZE; i++) {
+		if (i < 3) {
+			pos_score[i] = last_tri_score;
+		}
+		else {
+			const float scaler = 1.f / (VCACHE_SIZE - 3);
+			pos_score[i] = powf(1.f - (i - 3) * scaler, cache_decay);
+		}
+	}
+	auto vertScore = [&](const int cache_pos, const uint32_t valence) {
+		if (valence == 0) {
+			return -1.f;
+		}
+		float score = (cache_pos < 0) ? 0.f : pos_score[cache_pos];
+		return score + valence_scale * powf((float)valence, -valence_power);
+	};
+
+	// vertex -> triangle adjacency
+	dd_scratch_array<uint32_t> valence(num_verts);
+	for (size_t i = 0; i < num_tris; i++) {
+		for (unsigned j = 0; j < 3; j++) {
+			valence[tris[i].data[j]] += 1;
+		}
+	}
+	dd_scratch_array<uint32_t> adj_offset(num_verts + 1);
+	for (size_t i = 0; i < num_verts; i++) {
+		adj_offset[i + 1] = adj_offset[i] + valence[i];
+	}
+	dd_scratch_array<uint32_t> adj_tris(num_tris * 3);
+	dd_scratch_array<uint32_t> adj_fill(num_verts);
+	for (size_t i = 0; i < num_tris; i++) {
+		for (unsigned j = 0; j < 3; j++) {
+			const uint32_t v = tris[i].data[j];
+			adj_tris[adj_offset[v] + adj_fill[v]] = (uint32_t)i;
+			adj_fill[v] += 1;
+		}
+	}
+
+	// per vertex state (remaining valence, cache position, score)
+	dd_scratch_array<int> cache_pos(num_verts);
+	dd_scratch_array<float> v_score(num_verts);
+	for (size_t i = 0; i < num_verts; i++) {
+		cache_pos[i] = -1;
+		v_score[i] = vertScore(-1, valence[i]);
+	}
+	dd_scratch_array<float> t_score(num_tris);
+	dd_scratch_array<uint8_t> t_added(num_tris);
+	for (size_t i = 0; i < num_tris; i++) {
+		t_score[i] = v_score[tris[i].x()] + v_score[tris[i].y()] +
+			v_score[tris[i].z()];
+	}
+
+	// remove triangle from a vertex's live adjacency list
+	auto removeAdj = [&](const uint32_t v, const uint32_t tri) {
+		const uint32_t begin = adj_offset[v];
+		const uint32_t end = begin + valence[v];
+		for (uint32_t k = begin; k < end; k++) {
+			if (adj_tris[k] == tri) {
+				adj_tris[k] = adj_tris[end - 1];
+				break;
+			}
+		}
+		valence[v] -= 1;
+	};
+
+	dd_array<vec3_u> ordered(num_tris);
+	uint32_t cache[VCACHE_SIZE + 3];
+	unsigned cache_count = 0;
+	int best_tri = -1;
+	size_t next_unadded = 0;
+
+	for (size_t out = 0; out < num_tris; out++) {
+		if (best_tri < 0) {
+			// nothing useful in the cache: fall back to the best remaining
+			float best = -1.f;
+			for (size_t i = next_unadded; i < num_tris; i++) {
+				if (!t_added[i] && t_score[i] > best) {
+					best = t_score[i];
+					best_tri = (int)i;
+				}
+			}
+		}
+		const uint32_t tri = (uint32_t)best_tri;
+		ordered[out] = tris[tri];
+		t_added[tri] = 1;
+		while (next_unadded < num_tris && t_added[next_unadded]) {
+			next_unadded += 1;
+		}
+
+		// push triangle verts to the front of the LRU cache
+		uint32_t new_cache[VCACHE_SIZE + 3];
+		unsigned new_count = 0;
+		for (unsigned j = 0; j < 3; j++) {
+			const uint32_t v = tris[tri].data[j];
+			new_cache[new_count++] = v;
+			removeAdj(v, tri);
+		}
+		for (unsigned k = 0; k < cache_count; k++) {
+			const uint32_t v = cache[k];
+			if (v != tris[tri].x() && v != tris[tri].y() && v != tris[tri].z()) {
+				new_cache[new_count++] = v;
+			}
+		}
+
+		// rescore verts in (and evicted from) the cache + their triangles
+		for (unsigned k = 0; k < new_count; k++) {
+			const uint32_t v = new_cache[k];
+			cache_pos[v] = (k < VCACHE_SIZE) ? (int)k : -1;
+			const float new_score = vertScore(cache_pos[v], valence[v]);
+			const float delta = new_score - v_score[v];
+			v_score[v] = new_score;
+			const uint32_t begin = adj_offset[v];
+			for (uint32_t a = begin; a < begin + valence[v]; a++) {
+				t_score[adj_tris[a]] += delta;
+			}
+		}
+		cache_count = (new_count < VCACHE_SIZE) ? new_count : VCACHE_SIZE;
+
+		// next triangle: best one touching the cache (picked once every
+		// score is final, a triangle can share several rescored verts)
+		best_tri = -1;
+		float best = -1.f;
+		for (unsigned k = 0; k < cache_count; k++) {
+			const uint32_t v = new_cache[k];
+			const uint32_t begin = adj_offset[v];
+			for (uint32_t a = begin; a < begin + valence[v]; a++) {
+				const uint32_t t = adj_tris[a];
+				if (t_score[t] > best) {
+					best = t_score[t];
+					best_tri = (int)t;
+				}
+			}
+		}
+		for (unsigned k = 0; k < cache_count; k++) {
+			cache[k] = new_cache[k];
+		}
+	}
+	tris = std::move(ordered);
+}
+
+/// \brief Reorder each EBO for post-transform cache locality (Forsyth), then
+/// reorder vertex buffer in first-use order for vertex fetch locality
+void AssetFBX::optimizeVertCache()
+{
+	const size_t num_verts = m_verts.size();
+	for (size_t i = 0; i < m_ebos.size(); i++) {
+		float acmr_in, atvr_in, acmr_out, atvr_out;
+		vertCacheStats(m_ebos[i].indices, num_verts, acmr_in, atvr_in);
+		forsythReorder(m_ebos[i].indices, num_verts);
+		vertCacheStats(m_ebos[i].indices, num_verts, acmr_out, atvr_out);
+		printf("ebo #%lu: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+			   i, acmr_in, acmr_out, atvr_in, atvr_out);
+	}
+
+	// vertex fetch: number verts in the order the optimized ebos touch them
+	const uint32_t unused = (uint32_t)-1;
+	dd_array<uint32_t> remap(num_verts);
+	for (size_t i = 0; i < num_verts; i++) {
+		remap[i] = unused;
+	}
+	uint32_t next_idx = 0;
+	for (size_t i = 0; i < m_ebos.size(); i++) {
+		for (size_t j = 0; j < m_ebos[i].indices.size(); j++) {
+			for (unsigned k = 0; k < 3; k++) {
+				uint32_t& v = m_ebos[i].indices[j].data[k];
+				if (remap[v] == unused) {
+					remap[v] = next_idx++;
+				}
+				v = remap[v];
+			}
+		}
+	}
+	dd_array<VertPNTUV> ordered(num_verts);
+	for (size_t i = 0; i < num_verts; i++) {
+		if (remap[i] == unused) {
+			remap[i] = next_idx++;
+		}
+		ordered[remap[i]] = m_verts[i];
+	}
+	m_verts = std::move(ordered);
+	for (size_t i = 0; i < m_shapes.size(); i++) {
+		m_shapes[i].remap(remap);
+	}
+}
+
+bool SkelFbx::sortTopological()
+{
+	const uint32_t num_joints = m_numJoints;
+	auto isRoot = [&](const uint32_t j) {
+		return m_joints[j].m_parent == j || m_joints[j].m_parent >= num_joints;
+	};
+	// children lists (packed by parent, original order kept)
+	dd_array<uint32_t> child_start(num_joints + 1);
+	dd_array<uint32_t> children(num_joints);
+	for (uint32_t j = 0; j < num_joints; j++) {
+		if (!isRoot(j)) {
+			child_start[m_joints[j].m_parent + 1] += 1;
+		}
+	}
+	for (uint32_t j = 0; j < num_joints; j++) {
+		child_start[j + 1] += child_start[j];
+	}
+	{
+		dd_array<uint32_t> fill(num_joints);
+		for (uint32_t j = 0; j < num_joints; j++) {
+			fill[j] = child_start[j];
+		}
+		for (uint32_t j = 0; j < num_joints; j++) {
+			if (!isRoot(j)) {
+				children[fill[m_joints[j].m_parent]++] = j;
+			}
+		}
+	}
+
+	// depth first pre-order from each root
+	dd_array<uint32_t> order(num_joints);
+	dd_array<uint32_t> remap(num_joints);
+	dd_array<uint32_t> stack(num_joints);
+	dd_array<uint8_t> placed(num_joints);
+	uint32_t count = 0;
+	for (uint32_t r = 0; r < num_joints; r++) {
+		if (!isRoot(r)) {
+			continue;
+		}
+		uint32_t top = 0;
+		stack[top++] = r;
+		while (top > 0) {
+			const uint32_t j = stack[--top];
+			placed[j] = 1;
+			remap[j] = count;
+			order[count++] = j;
+			// push in reverse so children come out in original order
+			for (uint32_t c = child_start[j + 1]; c-- > child_start[j];) {
+				stack[top++] = children[c];
+			}
+		}
+	}
+	// joints on a parent cycle keep their relative order at the end
+	for (uint32_t j = 0; j < num_joints; j++) {
+		if (!placed[j]) {
+			remap[j] = count;
+			order[count++] = j;
+		}
+	}
+
+	bool moved = false;
+	for (uint32_t j = 0; j < num_joints; j++) {
+		moved |= order[j] != j;
+	}
+	if (!moved) {
+		return false;
+	}
+
+	dd_array<JointFBX> sorted(m_joints.size());
+	for (uint32_t j = 0; j < num_joints; j++) {
+		JointFBX& _j = sorted[j];
+		_j = m_joints[order[j]];
+		_j.m_idx = (uint16_t)j;
+		if (!isRoot(order[j])) {
+			_j.m_parent = (uint16_t)remap[_j.m_parent];
+		}
+		else {
+			_j.m_parent = (uint16_t)j;	// root points at itself
+		}
+	}
+	m_joints = std::move(sorted);
+	for (auto& entry : m_nodeIndex) {
+		entry.second = (uint16_t)remap[entry.second];
+	}
+	for (auto& entry : m_nameIndex) {
+		entry.second = (uint16_t)remap[entry.second];
+	}
+	return true;
+}
+
 /// \brief Export skeleton to format specified by dd_entity_map.txt
 void AssetFBX::exportSkeleton()
 {
 	cbuff<512> buff512;
 	buff512.format("%s%s.ddb", m_fbxPath.str(), m_fbxName.str());
-	std::fstream outfile;
-	outfile.open(buff512.str(), std::ofstream::out);
+	TextWriterFBX outfile;
 
 	// check file is open
-	if (outfile.bad()) {
+	if (!outfile.open(buff512.str(), m_compression, m_compressLevel)) {
 		printf("Could not open skeleton output file\n" );
+		m_exportFailed = true;
 		return;
 	}
 
 	// size
-	buff512.format("%u\n", m_skeleton.m_numJoints);
-	outfile << "<size>\n" << buff512.str() << "</size>\n";
+	outfile.put("<size>\n");
+	outfile.putUint(m_skeleton.m_numJoints);
+	outfile.put("\n</size>\n");
 
 	// joint to world space
-	buff512.format("p %.3f %.3f %.3f\n",
-				   m_skeleton.m_wspos.x(),
-				   m_skeleton.m_wspos.y(),
-				   m_skeleton.m_wspos.z());
-	outfile << "<global>\n" << buff512.str();
+	outfile.put("<global>\n");
+	outfile.floatLine("p",
+					  m_skeleton.m_wspos.x(),
+					  m_skeleton.m_wspos.y(),
+					  m_skeleton.m_wspos.z());
 
 	// change rotation if vicon fix is active
 	if (m_viconFormat) {
-		buff512.format("r %.3f %.3f %.3f\n",
-					   m_skeleton.m_wsrot.x() - 90.f,
-					   m_skeleton.m_wsrot.y() + 180.f,
-					   m_skeleton.m_wsrot.z());
-		outfile << buff512.str();
+		outfile.floatLine("r",
+						  m_skeleton.m_wsrot.x() - 90.f,
+						  m_skeleton.m_wsrot.y() + 180.f,
+						  m_skeleton.m_wsrot.z());
 	}
 	else {
-		buff512.format("r %.3f %.3f %.3f\n",
-					   m_skeleton.m_wsrot.x(),
-					   m_skeleton.m_wsrot.y(),
-					   m_skeleton.m_wsrot.z());
-		outfile << buff512.str();
-	}
-	buff512.format("s %.3f %.3f %.3f\n",
-				   m_skeleton.m_wsscl.x(),
-				   m_skeleton.m_wsscl.y(),
-				   m_skeleton.m_wsscl.z());
-	outfile << buff512.str() << "</global>\n";
+		outfile.floatLine("r",
+						  m_skeleton.m_wsrot.x(),
+						  m_skeleton.m_wsrot.y(),
+						  m_skeleton.m_wsrot.z());
+	}
+	outfile.floatLine("s",
+					  m_skeleton.m_wsscl.x(),
+					  m_skeleton.m_wsscl.y(),
+					  m_skeleton.m_wsscl.z());
+	outfile.put("</global>\n");
 
 	// joints
 	for (size_t i = 0; i < m_skeleton.m_numJoints; i++) {
 		JointFBX& _j = m_skeleton.m_joints[i];
-		buff512.format("%s %u %u\n", _j.m_name.str(), _j.m_idx, _j.m_parent);
-		outfile << "<joint>\n" << buff512.str();
-		buff512.format("p %.3f %.3f %.3f\n", 
-					   _j.m_lspos.x() * scale_factor,
-					   _j.m_lspos.y() * scale_factor,
-					   _j.m_lspos.z() * scale_factor);
-		outfile << buff512.str();
-		buff512.format("r %.3f %.3f %.3f\n",
-					   _j.m_lsrot.x(),
-					   _j.m_lsrot.y(),
-					   _j.m_lsrot.z());
-		outfile << buff512.str();
-		buff512.format("s %.3f %.3f %.3f\n",
-					   _j.m_lsscl.x(),
-					   _j.m_lsscl.y(),
-					   _j.m_lsscl.z());
-		outfile << buff512.str() << "</joint>\n";
+		outfile.put("<joint>\n");
+		outfile.put(_j.m_name.str());
+		outfile.put(' ');
+		outfile.putUint(_j.m_idx);
+		outfile.put(' ');
+		outfile.putUint(_j.m_parent);
+		outfile.put('\n');
+		outfile.floatLine("p",
+						  _j.m_lspos.x() * scale_factor,
+						  _j.m_lspos.y() * scale_factor,
+						  _j.m_lspos.z() * scale_factor);
+		outfile.floatLine("r", _j.m_lsrot.x(), _j.m_lsrot.y(), _j.m_lsrot.z());
+		outfile.floatLine("s", _j.m_lsscl.x(), _j.m_lsscl.y(), _j.m_lsscl.z());
+		outfile.put("</joint>\n");
+	}
+	outfile.close();
+	checkWrite(outfile.failed(), buff512.str());
+}
+
+/// \brief Export skeleton to binary DDB layout specified by DD_Binary.h
+void AssetFBX::exportSkeletonBinary()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	cbuff<512> buff512;
+	buff512.format("%s%s.ddbb", m_fbxPath.str(), m_fbxName.str());
+	std::fstream outfile;
+	outfile.open(buff512.str(), std::ios::out | std::ios::binary);
+
+	// check file is open
+	if (!outfile.is_open()) {
+		printf("Could not open binary skeleton output file\n");
+		m_exportFailed = true;
+		return;
+	}
+
+	const uint32_t num_joints = m_skeleton.m_numJoints;
+	DDBHeader header;
+	memset(&header, 0, sizeof(DDBHeader));
+	memcpy(header.magic, "DDBB", 4);
+	header.version = DDB_BIN_VERSION;
+	header.num_joints = num_joints;
+	for (unsigned i = 0; i < 3; i++) {
+		header.wspos[i] = m_skeleton.m_wspos.data[i];
+		header.wsrot[i] = m_skeleton.m_wsrot.data[i];
+		header.wsscl[i] = m_skeleton.m_wsscl.data[i];
+	}
+	// change rotation if vicon fix is active
+	if (m_viconFormat) {
+		header.wsrot[0] -= 90.f;
+		header.wsrot[1] += 180.f;
+	}
+	header.joint_offset = ddBinAlign(sizeof(DDBHeader));
+	header.bind_offset = ddBinAlign(header.joint_offset +
+									num_joints * sizeof(DDBJoint));
+	const uint64_t file_end = ddBinAlign(header.bind_offset +
+										 num_joints * sizeof(DDBInvBind));
+
+	dd_array<DDBJoint> joints(num_joints);
+	dd_array<DDBInvBind> binds(num_joints);
+	for (uint32_t i = 0; i < num_joints; i++) {
+		JointFBX& _j = m_skeleton.m_joints[i];
+		DDBJoint& _out = joints[i];
+		snprintf(_out.name, sizeof(_out.name), "%s", _j.m_name.str());
+		_out.idx = _j.m_idx;
+		_out.parent = _j.m_parent;
+		for (unsigned k = 0; k < 3; k++) {
+			_out.pos[k] = _j.m_lspos.data[k] * scale_factor;
+			_out.rot[k] = _j.m_lsrot.data[k];
+			_out.scl[k] = _j.m_lsscl.data[k];
+		}
+		// export scale only moves the translation column
+		for (unsigned k = 0; k < 12; k++) {
+			binds[i].m[k] = _j.m_invBind[k] * ((k % 4 == 3) ? scale_factor : 1.f);
+		}
 	}
+
+	// pad stream out to the next section offset
+	const char zeros[DD_BIN_ALIGN] = {};
+	auto padTo = [&](const uint64_t target) {
+		const uint64_t pos = (uint64_t)outfile.tellp();
+		if (target > pos) {
+			outfile.write(zeros, (std::streamsize)(target - pos));
+		}
+	};
+
+	outfile.write((const char*)&header, sizeof(DDBHeader));
+	padTo(header.joint_offset);
+	if (joints.isValid()) {
+		outfile.write((const char*)&joints[0], joints.sizeInBytes());
+	}
+	padTo(header.bind_offset);
+	if (binds.isValid()) {
+		outfile.write((const char*)&binds[0], binds.sizeInBytes());
+	}
+	padTo(file_end);
+
+	const uint64_t file_size = (uint64_t)outfile.tellp();
+	outfile.close();
+	checkWrite(outfile.fail(), buff512.str());
+
+	auto end = std::chrono::high_resolution_clock::now();
+	const double write_ms =
+		std::chrono::duration<double, std::milli>(end - start).count();
+	printf("Binary skeleton: %s (%u joints, %llu bytes, %.3f ms)\n",
+		   buff512.str(), num_joints, (unsigned long long)file_size, write_ms);
 }
 
 /// \brief Export mesh to format specified by dd_entity_map.txt
 void AssetFBX::exportMesh()
 {
+	auto start = std::chrono::high_resolution_clock::now();
 	cbuff<512> buff512;
 	// remove/replace restricted filename symbols
 	std::string id = m_id.str();
 	std::replace(id.begin(), id.end(), ':', '_');
 
 	buff512.format("%s%s.ddm", m_fbxPath.str(), id.c_str());
-	std::fstream outfile;
-	outfile.open(buff512.str(), std::ios::out);
+	TextWriterFBX outfile;
 
 	// check file is open
-	if (outfile.bad()) {
+	if (!outfile.open(buff512.str(), m_compression, m_compressLevel)) {
 		printf("Could not open mesh output file\n" );
+		m_exportFailed = true;
 		return;
 	}
 
 	// name
-	buff512.format("%s\n", m_id.str());
-	outfile << "<name>\n" << buff512.str() << "</name>\n";
+	outfile.put("<name>\n");
+	outfile.put(m_id.str());
+	outfile.put("\n</name>\n");
 
 	// buffer sizes
-	buff512.format("v %lu\n", m_verts.size());
-	outfile << "<buffer>\n" << buff512.str();
-	buff512.format("e %lu\n", m_ebos.size());
-	outfile << buff512.str();
-	buff512.format("m %lu\n", m_matbin.size());
-	outfile << buff512.str() << "</buffer>\n";
+	outfile.put("<buffer>\n");
+	outfile.uintLine("v", m_verts.size());
+	outfile.uintLine("e", m_ebos.size());
+	outfile.uintLine("m", m_matbin.size());
+	if (m_shapes.size() > 0) {
+		outfile.uintLine("s", m_shapes.size());
+	}
+	outfile.put("</buffer>\n");
 
 	// material data
+	auto texLine = [&](const char* tag, const char* path) {
+		outfile.put(tag);
+		outfile.put(' ');
+		outfile.put(path);
+		outfile.put('\n');
+	};
 	for (size_t i = 0; i < m_matbin.size(); i++) {
 		MatFBX& _m = m_matbin[i];
-		buff512.format("n %s\n", _m.m_id.str());
-		outfile << "<material>\n" << buff512.str();
+		outfile.put("<material>\n");
+		texLine("n", _m.m_id.str());
 		if (bool(_m.m_textypes & MatType::DIFF)) {
-			buff512.format("D %s\n", _m.m_diffmap.str());
-			outfile << buff512.str();
+			texLine("D", _m.m_diffmap.str());
 		}
 		if (bool(_m.m_textypes & MatType::NORMAL)) {
-			buff512.format("N %s\n", _m.m_normmap.str());
-			outfile << buff512.str();
+			texLine("N", _m.m_normmap.str());
 		}
 		if (bool(_m.m_textypes & MatType::SPEC)) {
-			buff512.format("S %s\n", _m.m_specmap.str());
-			outfile << buff512.str();
+			texLine("S", _m.m_specmap.str());
 		}
 		if (bool(_m.m_textypes & MatType::ROUGH)) {
-			buff512.format("R %s\n", _m.m_roughmap.str());
-			outfile << buff512.str();
+			texLine("R", _m.m_roughmap.str());
 		}
 		if (bool(_m.m_textypes & MatType::METAL)) {
-			buff512.format("M %s\n", _m.m_metalmap.str());
-			outfile << buff512.str();
+			texLine("M", _m.m_metalmap.str());
 		}
 		if (bool(_m.m_textypes & MatType::EMIT)) {
-			buff512.format("E %s\n", _m.m_emitmap.str());
-			outfile << buff512.str();
+			texLine("E", _m.m_emitmap.str());
 		}
 		if (bool(_m.m_textypes & MatType::AO)) {
-			buff512.format("A %s\n", _m.m_aomap.str());
-			outfile << buff512.str();
+			texLine("A", _m.m_aomap.str());
 		}
 		// vector properties
-		buff512.format("a %.3f %.3f %.3f\n", 
-					   _m.m_ambient.x(), _m.m_ambient.y(), _m.m_ambient.z());
-		outfile << buff512.str();
-		buff512.format("d %.3f %.3f %.3f\n",
-					   _m.m_diffuse.x(), _m.m_diffuse.y(), _m.m_diffuse.z());
-		outfile << buff512.str();
-		buff512.format("s %.3f %.3f %.3f\n",
-					   _m.m_specular.x(), _m.m_specular.y(), _m.m_specular.z());
-		outfile << buff512.str();
-		buff512.format("e %.3f %.3f %.3f\n",
-					   _m.m_emmisive.x(), _m.m_emmisive.y(), _m.m_emmisive.z());
-		outfile << buff512.str();
+		outfile.floatLine("a",
+						  _m.m_ambient.x(), _m.m_ambient.y(), _m.m_ambient.z());
+		outfile.floatLine("d",
+						  _m.m_diffuse.x(), _m.m_diffuse.y(), _m.m_diffuse.z());
+		outfile.floatLine("s",
+						  _m.m_specular.x(), _m.m_specular.y(), _m.m_specular.z());
+		outfile.floatLine("e",
+						  _m.m_emmisive.x(), _m.m_emmisive.y(), _m.m_emmisive.z());
 
 		// float properties
-		buff512.format("x %.3f\n", _m.m_transfactor);
-		outfile << buff512.str();
-		buff512.format("y %.3f\n", _m.m_reflectfactor);
-		outfile << buff512.str();
-		buff512.format("z %.3f\n", _m.m_specfactor);
-		outfile << buff512.str() << "</material>\n";
+		outfile.floatLine("x", _m.m_transfactor);
+		outfile.floatLine("y", _m.m_reflectfactor);
+		outfile.floatLine("z", _m.m_specfactor);
+		outfile.put("</material>\n");
 	}
 
 	// vertex data
-	outfile << "<vertex>\n";
+	outfile.put("<vertex>\n");
 	for (size_t i = 0; i < m_verts.size(); i++) {
-		buff512.format("v %.3f %.3f %.3f\n",
-					   m_verts[i].m_pos.x() * scale_factor,
-					   m_verts[i].m_pos.y() * scale_factor,
-					   m_verts[i].m_pos.z() * scale_factor);
-		outfile << buff512.str();
-		buff512.format("n %.3f %.3f %.3f\n",
-					   m_verts[i].m_norm.x(),
-					   m_verts[i].m_norm.y(),
-					   m_verts[i].m_norm.z());
-		outfile << buff512.str();
-		buff512.format("t %.3f %.3f %.3f\n",
-					   m_verts[i].m_tang.x(),
-					   m_verts[i].m_tang.y(),
-					   m_verts[i].m_tang.z());
-		outfile << buff512.str();
-		buff512.format("u %.3f %.3f\n",
-					   m_verts[i].m_uv.x(),
-					   m_verts[i].m_uv.y());
-		outfile << buff512.str();
-		buff512.format("j %u %u %u %u\n",
-					   m_verts[i].m_joint.x(),
-					   m_verts[i].m_joint.y(),
-					   m_verts[i].m_joint.z(),
-					   m_verts[i].m_joint.w());
-		outfile << buff512.str();
-		buff512.format("b %.3f %.3f %.3f %.3f\n",
-					   m_verts[i].m_jblend.x(),
-					   m_verts[i].m_jblend.y(),
-					   m_verts[i].m_jblend.z(),
-					   m_verts[i].m_jblend.w());
-		outfile << buff512.str();
-	}
-	outfile << "</vertex>\n";
+		const VertPNTUV& _v = m_verts[i];
+		outfile.floatLine("v",
+						  _v.m_pos.x() * scale_factor,
+						  _v.m_pos.y() * scale_factor,
+						  _v.m_pos.z() * scale_factor);
+		outfile.floatLine("n", _v.m_norm.x(), _v.m_norm.y(), _v.m_norm.z());
+		outfile.floatLine("t", _v.m_tang.x(), _v.m_tang.y(), _v.m_tang.z());
+		outfile.floatLine("u", _v.m_uv.x(), _v.m_uv.y());
+		outfile.uintLine("j",
+						 _v.m_joint.x(),
+						 _v.m_joint.y(),
+						 _v.m_joint.z(),
+						 _v.m_joint.w());
+		outfile.floatLine("b",
+						  _v.m_jblend.x(),
+						  _v.m_jblend.y(),
+						  _v.m_jblend.z(),
+						  _v.m_jblend.w());
+	}
+	outfile.put("</vertex>\n");
 
 	// ebo data
 	for (size_t i = 0; i < m_ebos.size(); i++) {
 		EboMesh& _e = m_ebos[i];
-		buff512.format("s %lu\n", _e.indices.size() * 3); // ebo size
-		outfile << "<ebo>\n" << buff512.str();
-		buff512.format("m %lu\n", i); // material index
-		outfile << buff512.str();
+		outfile.put("<ebo>\n");
+		outfile.uintLine("s", _e.indices.size() * 3); // ebo size
+		outfile.uintLine("m", i); // material index
 
 		for (size_t j = 0; j < _e.indices.size(); j++) {
-			buff512.format("- %u %u %u\n",
-						   _e.indices[j].x(),
-						   _e.indices[j].y(),
-						   _e.indices[j].z());
-			outfile << buff512.str();
+			outfile.uintLine("-",
+							 _e.indices[j].x(),
+							 _e.indices[j].y(),
+							 _e.indices[j].z());
 		}
-		outfile << "</ebo>\n";
+		outfile.put("</ebo>\n");
 	}
 
-	outfile.flush();
-	//outfile.close();
+	// blend shape data (sparse deltas)
+	for (size_t i = 0; i < m_shapes.size(); i++) {
+		ShapeFBX& _s = m_shapes[i];
+		outfile.put("<shape>\n");
+		outfile.put("- ");
+		outfile.put(_s.m_id.str());
+		outfile.put('\n');
+		outfile.uintLine("s", _s.m_indices.size());
+		for (size_t j = 0; j < _s.m_indices.size(); j++) {
+			outfile.uintLine("i", _s.m_indices[j]);
+			outfile.floatLine("p",
+							  _s.m_dpos[j].x() * scale_factor,
+							  _s.m_dpos[j].y() * scale_factor,
+							  _s.m_dpos[j].z() * scale_factor);
+			outfile.floatLine("n",
+							  _s.m_dnorm[j].x(),
+							  _s.m_dnorm[j].y(),
+							  _s.m_dnorm[j].z());
+		}
+		outfile.put("</shape>\n");
+	}
+
+	outfile.close();
+	checkWrite(outfile.failed(), buff512.str());
+
+	auto end = std::chrono::high_resolution_clock::now();
+	const double write_ms =
+		std::chrono::duration<double, std::milli>(end - start).count();
+	printf("Text mesh: %s%s.ddm%s (%llu bytes, %llu on disk, %.3f ms)\n",
+		   m_fbxPath.str(), id.c_str(), TextWriterFBX::extension(m_compression),
+		   (unsigned long long)outfile.bytesWritten(),
+		   (unsigned long long)outfile.fileBytes(), write_ms);
+}
+
+/// \brief Skin weight as stored in a binary vertex (float or unorm, weights
+/// are already snapped to unorm steps by resolveSkinWeights)
+inline void packWeight(const float weight, float &out) { out = weight; }
+inline void packWeight(const float weight, uint8_t &out)
+{
+	out = (uint8_t)(weight * 255.f + 0.5f);
+}
+inline void packWeight(const float weight, uint16_t &out)
+{
+	out = (uint16_t)(weight * 65535.f + 0.5f);
+}
+
+/// \brief Pack vertices into binary DDM records (DDMVertexT) and write them
+/// w/ a single call
+template<typename V>
+void writeBinaryVerts(std::fstream &outfile,
+					  const dd_array<VertPNTUV> &src,
+					  const float scale)
+{
+	dd_array<V> verts(src.size());
+	for (size_t i = 0; i < src.size(); i++) {
+		const VertPNTUV& _v = src[i];
+		V& _out = verts[i];
+		for (unsigned j = 0; j < 3; j++) {
+			_out.pos[j] = _v.m_pos.data[j] * scale;
+			_out.norm[j] = _v.m_norm.data[j];
+			_out.tang[j] = _v.m_tang.data[j];
+		}
+		_out.uv[0] = _v.m_uv.x();
+		_out.uv[1] = _v.m_uv.y();
+		for (unsigned j = 0; j < 4; j++) {
+			_out.joint[j] = _v.m_joint.data[j];	// fits (checked by caller)
+			packWeight(_v.m_jblend.data[j], _out.blend[j]);
+		}
+	}
+	if (verts.isValid()) {
+		outfile.write((const char*)&verts[0], verts.sizeInBytes());
+	}
+}
+
+/// \brief Write vertices w/ joint index type J and skin weights as float
+/// (weight_bits 0) or 8/16-bit unorm
+template<typename J>
+void writeBinaryVertsJ(std::fstream &outfile,
+					   const dd_array<VertPNTUV> &src,
+					   const float scale,
+					   const uint32_t weight_bits)
+{
+	switch (weight_bits) {
+		case 8:
+			writeBinaryVerts<DDMVertexT<J, uint8_t>>(outfile, src, scale);
+			break;
+		case 16:
+			writeBinaryVerts<DDMVertexT<J, uint16_t>>(outfile, src, scale);
+			break;
+		default:
+			writeBinaryVerts<DDMVertexT<J, float>>(outfile, src, scale);
+			break;
+	}
+}
+
+/// \brief Export mesh to binary DDM layout specified by DD_Binary.h
+void AssetFBX::exportMeshBinary()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	cbuff<512> buff512;
+	// remove/replace restricted filename symbols
+	std::string id = m_id.str();
+	std::replace(id.begin(), id.end(), ':', '_');
+
+	buff512.format("%s%s.ddmb", m_fbxPath.str(), id.c_str());
+	std::fstream outfile;
+	outfile.open(buff512.str(), std::ios::out | std::ios::binary);
+
+	// check file is open
+	if (!outfile.is_open()) {
+		printf("Could not open binary mesh output file\n");
+		m_exportFailed = true;
+		return;
+	}
+
+	// lay out sections (each section starts on a DD_BIN_ALIGN boundary)
+	const uint32_t name_len = (uint32_t)strlen(m_id.str());
+	DDMHeader header;
+	memset(&header, 0, sizeof(DDMHeader));
+	memcpy(header.magic, "DDMB", 4);
+	header.version = DDM_BIN_VERSION;
+	// compact 8-bit joint indices whenever the rig fits
+	uint16_t max_joint = 0;
+	for (size_t i = 0; i < m_verts.size(); i++) {
+		for (unsigned j = 0; j < 4; j++) {
+			max_joint = std::max(max_joint, m_verts[i].m_joint.data[j]);
+		}
+	}
+	const bool joint8 = max_joint <= 0xFF;
+	// unorm skin weights when they were snapped (--weight-bits)
+	const uint32_t weight_bits =
+		(m_weightBits == 8 || m_weightBits == 16) ? m_weightBits : 0;
+	header.flags = joint8 ? DDM_FLAG_JOINT8 : 0;
+	header.flags |= (weight_bits == 8) ? DDM_FLAG_WEIGHT8 : 0;
+	header.flags |= (weight_bits == 16) ? DDM_FLAG_WEIGHT16 : 0;
+	header.vert_stride = joint8 ? ddmVertStride<uint8_t>(weight_bits) :
+		ddmVertStride<uint16_t>(weight_bits);
+	header.num_verts = (uint32_t)m_verts.size();
+	header.num_ebos = (uint32_t)m_ebos.size();
+	header.num_mats = (uint32_t)m_matbin.size();
+	header.name_offset = ddBinAlign(sizeof(DDMHeader));
+	header.mat_offset = ddBinAlign(header.name_offset + sizeof(uint32_t) +
+								   name_len);
+	header.vert_offset = ddBinAlign(header.mat_offset +
+									header.num_mats * sizeof(DDMMaterial));
+	header.ebo_offset = ddBinAlign(header.vert_offset +
+								   (uint64_t)header.num_verts * header.vert_stride);
+
+	dd_array<DDMEbo> ebo_table(m_ebos.size());
+	uint64_t offset = ddBinAlign(header.ebo_offset +
+								 header.num_ebos * sizeof(DDMEbo));
+	for (size_t i = 0; i < m_ebos.size(); i++) {
+		ebo_table[i].mat_idx = (uint32_t)i;
+		ebo_table[i].num_indices = (uint32_t)(m_ebos[i].indices.size() * 3);
+		ebo_table[i].offset = offset;
+		offset = ddBinAlign(offset + ebo_table[i].num_indices * sizeof(uint32_t));
+	}
+
+	// blend shape table followed by index/delta blobs
+	header.num_shapes = (uint32_t)m_shapes.size();
+	dd_array<DDMShape> shape_table(m_shapes.size());
+	if (header.num_shapes > 0) {
+		header.shape_offset = offset;
+		offset = ddBinAlign(offset + header.num_shapes * sizeof(DDMShape));
+	}
+	for (size_t i = 0; i < m_shapes.size(); i++) {
+		DDMShape& _out = shape_table[i];
+		memset(&_out, 0, sizeof(DDMShape));
+		snprintf(_out.id, sizeof(_out.id), "%s", m_shapes[i].m_id.str());
+		_out.num_deltas = (uint32_t)m_shapes[i].m_indices.size();
+		_out.offset = offset;
+		offset = ddBinAlign(ddmShapeDeltaOffset(_out) +
+							_out.num_deltas * sizeof(DDMShapeDelta));
+	}
+
+	// pad stream out to the next section offset
+	const char zeros[DD_BIN_ALIGN] = {};
+	auto padTo = [&](const uint64_t target) {
+		const uint64_t pos = (uint64_t)outfile.tellp();
+		if (target > pos) {
+			outfile.write(zeros, (std::streamsize)(target - pos));
+		}
+	};
+
+	outfile.write((const char*)&header, sizeof(DDMHeader));
+
+	// name
+	padTo(header.name_offset);
+	outfile.write((const char*)&name_len, sizeof(uint32_t));
+	outfile.write(m_id.str(), name_len);
+
+	// material data
+	padTo(header.mat_offset);
+	for (size_t i = 0; i < m_matbin.size(); i++) {
+		MatFBX& _m = m_matbin[i];
+		DDMMaterial mat;
+		memset(&mat, 0, sizeof(DDMMaterial));
+		snprintf(mat.id, sizeof(mat.id), "%s", _m.m_id.str());
+		snprintf(mat.diffmap, sizeof(mat.diffmap), "%s", _m.m_diffmap.str());
+		snprintf(mat.normmap, sizeof(mat.normmap), "%s", _m.m_normmap.str());
+		snprintf(mat.specmap, sizeof(mat.specmap), "%s", _m.m_specmap.str());
+		snprintf(mat.roughmap, sizeof(mat.roughmap), "%s", _m.m_roughmap.str());
+		snprintf(mat.metalmap, sizeof(mat.metalmap), "%s", _m.m_metalmap.str());
+		snprintf(mat.emitmap, sizeof(mat.emitmap), "%s", _m.m_emitmap.str());
+		snprintf(mat.aomap, sizeof(mat.aomap), "%s", _m.m_aomap.str());
+		for (unsigned j = 0; j < 3; j++) {
+			mat.ambient[j] = _m.m_ambient.data[j];
+			mat.diffuse[j] = _m.m_diffuse.data[j];
+			mat.specular[j] = _m.m_specular.data[j];
+			mat.emissive[j] = _m.m_emmisive.data[j];
+		}
+		mat.transfactor = _m.m_transfactor;
+		mat.reflectfactor = _m.m_reflectfactor;
+		mat.specfactor = _m.m_specfactor;
+		mat.textypes = (uint32_t)_m.m_textypes;
+		outfile.write((const char*)&mat, sizeof(DDMMaterial));
+	}
+
+	// vertex data (packed into one block and written w/ a single call)
+	padTo(header.vert_offset);
+	if (joint8) {
+		writeBinaryVertsJ<uint8_t>(outfile, m_verts, scale_factor, weight_bits);
+	}
+	else {
+		writeBinaryVertsJ<uint16_t>(outfile, m_verts, scale_factor, weight_bits);
+	}
+
+	// ebo table followed by index blobs
+	padTo(header.ebo_offset);
+	if (ebo_table.isValid()) {
+		outfile.write((const char*)&ebo_table[0], ebo_table.sizeInBytes());
+	}
+	for (size_t i = 0; i < m_ebos.size(); i++) {
+		EboMesh& _e = m_ebos[i];
+		padTo(ebo_table[i].offset);
+		for (size_t j = 0; j < _e.indices.size(); j++) {
+			outfile.write((const char*)_e.indices[j].data, sizeof(uint32_t) * 3);
+		}
+	}
+	if (shape_table.isValid()) {
+		padTo(header.shape_offset);
+		outfile.write((const char*)&shape_table[0], shape_table.sizeInBytes());
+	}
+	for (size_t i = 0; i < m_shapes.size(); i++) {
+		ShapeFBX& _s = m_shapes[i];
+		const uint32_t num_deltas = shape_table[i].num_deltas;
+		if (num_deltas == 0) {
+			continue;
+		}
+		padTo(shape_table[i].offset);
+		outfile.write((const char*)&_s.m_indices[0], _s.m_indices.sizeInBytes());
+		padTo(ddmShapeDeltaOffset(shape_table[i]));
+		dd_array<DDMShapeDelta> deltas(num_deltas);
+		for (uint32_t j = 0; j < num_deltas; j++) {
+			for (unsigned k = 0; k < 3; k++) {
+				deltas[j].pos[k] = _s.m_dpos[j].data[k] * scale_factor;
+				deltas[j].norm[k] = _s.m_dnorm[j].data[k];
+			}
+		}
+		outfile.write((const char*)&deltas[0], deltas.sizeInBytes());
+	}
+	padTo(offset);
+
+	const uint64_t file_size = (uint64_t)outfile.tellp();
+	outfile.close();
+	checkWrite(outfile.fail(), buff512.str());
+
+	auto end = std::chrono::high_resolution_clock::now();
+	const double write_ms =
+		std::chrono::duration<double, std::milli>(end - start).count();
+	printf("Binary mesh: %s (%u-bit joints, %llu bytes, %.3f ms)\n",
+		   buff512.str(), joint8 ? 8 : 16, (unsigned long long)file_size,
+		   write_ms);
 }
 
 /// \brief Export animation to format specified by dd_entity_map.txt
 void AssetFBX::exportAnimation()
 {
 	for(unsigned i = 0; i < m_clips.size(); i++) {
+		auto start = std::chrono::high_resolution_clock::now();
 		cbuff<512> buff512;
 		buff512.format("%s%s_%u.dda",  m_fbxPath.str(), m_fbxName.str(), i);
-		std::fstream outfile;
-		outfile.open(buff512.str(), std::ofstream::out);
+		TextWriterFBX outfile;
 	
 		// check file is open
-		if (outfile.bad()) {
+		if (!outfile.open(buff512.str(), m_compression, m_compressLevel)) {
 			printf("Could not open animation output file\n" );
+			m_exportFailed = true;
 			return;
 		}
 
 		// framerate
-		buff512.format("%.3f\n", m_clips[i].m_framerate);
-		outfile << "<framerate>\n" << buff512.str() << "</framerate>\n";
+		outfile.put("<framerate>\n");
+		outfile.putFloat(m_clips[i].m_framerate);
+		outfile.put("\n</framerate>\n");
 
 		// repeat
-		outfile << "<repeat>\n" << 0 << "\n</repeat>\n";
+		outfile.put("<repeat>\n0\n</repeat>\n");
 
 		// buffer sizes
-		buff512.format("j %u\n", m_clips[i].m_joints);
-		outfile << "<buffer>\n" << buff512.str();
-		buff512.format("f %lu\n", m_clips[i].m_clip.size());
-		outfile << buff512.str() << "</buffer>\n";
+		outfile.put("<buffer>\n");
+		outfile.uintLine("j", m_clips[i].m_joints);
+		outfile.uintLine("f", m_clips[i].m_frames);
+		if (m_clips[i].isReduced()) {
+			outfile.uintLine("k", m_clips[i].m_keys.size());
+		}
+		if (m_clips[i].m_numShapes > 0) {
+			outfile.uintLine("s", m_clips[i].m_numShapes);
+		}
+		outfile.put("</buffer>\n");
 
 		// animation data
 		for(unsigned j = 0; j < m_clips[i].m_joints; j++) {
-			buff512.format("- %u\n", j);
-			outfile << "<animation>\n" << buff512.str();
-			for(auto& p : m_clips[i].m_clip) {
-				buff512.format("r %.3f %.3f %.3f\n",
-							   p.second.pose[j].rot.x(),
-							   p.second.pose[j].rot.y(),
-							   p.second.pose[j].rot.z());
-				outfile << buff512.str();
-				buff512.format("p %.3f %.3f %.3f\n",
-							   p.second.pose[j].pos.x() * scale_factor,
-							   p.second.pose[j].pos.y() * scale_factor,
-							   p.second.pose[j].pos.z() * scale_factor);
-				outfile << buff512.str();
+			outfile.put("<animation>\n");
+			outfile.uintLine("-", j);
+			for(unsigned k = 0; k < m_clips[i].numKeys(j); k++) {
+				const unsigned f = m_clips[i].keyFrame(j, k);
+				const AnimSample& _s = m_clips[i].sample(f, j);
+				if (m_clips[i].isReduced()) {
+					outfile.uintLine("t", f);
+				}
+				outfile.floatLine("r", _s.rot.x(), _s.rot.y(), _s.rot.z());
+				outfile.floatLine("p",
+								  _s.pos.x() * scale_factor,
+								  _s.pos.y() * scale_factor,
+								  _s.pos.z() * scale_factor);
+			}
+			outfile.put("</animation>\n");
+		}
+
+		// blend shape weights (one per frame)
+		for(unsigned j = 0; j < m_clips[i].m_numShapes; j++) {
+			const float* weights =
+				&m_clips[i].m_shapeWeights[(size_t)j * m_clips[i].m_frames];
+			outfile.put("<shape>\n");
+			outfile.put("- ");
+			outfile.put(m_clips[i].m_shapeIds[j].str());
+			outfile.put('\n');
+			for(unsigned f = 0; f < m_clips[i].m_frames; f++) {
+				outfile.floatLine("w", weights[f]);
 			}
-			outfile << "</animation>\n";
+			outfile.put("</shape>\n");
 		}
 		outfile.close();
+		checkWrite(outfile.failed(), buff512.str());
+
+		auto end = std::chrono::high_resolution_clock::now();
+		const double write_ms =
+			std::chrono::duration<double, std::milli>(end - start).count();
+		printf("Text animation: %s%s (%llu bytes, %llu on disk, %.3f ms)\n",
+			   buff512.str(), TextWriterFBX::extension(m_compression),
+			   (unsigned long long)outfile.bytesWritten(),
+			   (unsigned long long)outfile.fileBytes(), write_ms);
+	}
+}
+
+namespace {
+
+/// \brief Euler rotation (degrees, x applied first) to quaternion (x, y, z, w)
+void eulerToQuat(const float x, const float y, const float z, float q[4])
+{
+	const double deg_to_half_rad = 3.14159265358979323846 / 360.0;
+	const double cx = cos(x * deg_to_half_rad), sx = sin(x * deg_to_half_rad);
+	const double cy = cos(y * deg_to_half_rad), sy = sin(y * deg_to_half_rad);
+	const double cz = cos(z * deg_to_half_rad), sz = sin(z * deg_to_half_rad);
+	// q = qz * qy * qx
+	q[0] = (float)(sx * cy * cz - cx * sy * sz);
+	q[1] = (float)(cx * sy * cz + sx * cy * sz);
+	q[2] = (float)(cx * cy * sz - sx * sy * cz);
+	q[3] = (float)(cx * cy * cz + sx * sy * sz);
+}
+
+/// \brief Map value in [min, min + extent] to a quant_bits fixed point value
+uint32_t quantize(const float val, const float min, const float extent,
+				  const uint32_t max_q)
+{
+	if (extent <= 0.f) {
+		return 0;
+	}
+	const float t = std::min(std::max((val - min) / extent, 0.f), 1.f);
+	return (uint32_t)(t * max_q + 0.5f);
+}
+
+float dequantize(const uint32_t q, const float min, const float extent,
+				 const uint32_t max_q)
+{
+	return min + extent * ((float)q / max_q);
+}
+
+/// \brief Quantize one joint's keys (rot/pos planes of num_keys floats) into
+/// the DDA_FLAG_QUANTIZED block layout. Returns max rotation error (degrees)
+/// and max position error of the decoded keys
+void quantizeJointTrack(const float *track,
+						const uint32_t num_keys,
+						const uint32_t quant_bits,
+						dd_array<uint8_t> &block,
+						float &rot_err,
+						float &pos_err)
+{
+	const uint32_t max_q = (1u << quant_bits) - 1;
+	const uint64_t elem = quant_bits <= 8 ? 1 : 2;
+	const uint64_t planes = sizeof(DDAQuantRange) + ddBinAlign(num_keys);
+	block.resize(planes + 6 * num_keys * elem);
+	DDAQuantRange range;
+	uint8_t *largest = &block[sizeof(DDAQuantRange)];
+
+	// smallest-three: drop the largest component (kept positive)
+	dd_scratch_array<float> comps(3 * num_keys);
+	dd_scratch_array<float> quats(4 * num_keys);
+	for (unsigned k = 0; k < num_keys; k++) {
+		float *q = &quats[4 * k];
+		eulerToQuat(track[k], track[num_keys + k], track[2 * num_keys + k], q);
+		uint8_t big = 0;
+		for (uint8_t c = 1; c < 4; c++) {
+			big = (fabs(q[c]) > fabs(q[big])) ? c : big;
+		}
+		const float sign = (q[big] < 0.f) ? -1.f : 1.f;
+		for (uint8_t c = 0, s = 0; c < 4; c++) {
+			q[c] *= sign;
+			if (c != big) {
+				comps[s * num_keys + k] = q[c];
+				s++;
+			}
+		}
+		largest[k] = big;
+	}
+
+	// per-track min/extent
+	for (unsigned c = 0; c < 3; c++) {
+		const float *rc = &comps[c * num_keys];
+		const float *pc = &track[(3 + c) * num_keys];
+		float rmin = rc[0], rmax = rc[0], pmin = pc[0], pmax = pc[0];
+		for (unsigned k = 1; k < num_keys; k++) {
+			rmin = std::min(rmin, rc[k]);
+			rmax = std::max(rmax, rc[k]);
+			pmin = std::min(pmin, pc[k]);
+			pmax = std::max(pmax, pc[k]);
+		}
+		range.rot_min[c] = rmin;
+		range.rot_extent[c] = rmax - rmin;
+		range.pos_min[c] = pmin;
+		range.pos_extent[c] = pmax - pmin;
+	}
+	memcpy(&block[0], &range, sizeof(DDAQuantRange));
+
+	// write planes and measure decode error
+	rot_err = 0.f;
+	pos_err = 0.f;
+	for (unsigned k = 0; k < num_keys; k++) {
+		float dq[4];
+		float sum_sq = 0.f;
+		for (uint8_t c = 0, s = 0; c < 4; c++) {
+			if (c == largest[k]) {
+				continue;
+			}
+			const uint32_t qv = quantize(comps[s * num_keys + k],
+										 range.rot_min[s], range.rot_extent[s],
+										 max_q);
+			dq[c] = dequantize(qv, range.rot_min[s], range.rot_extent[s], max_q);
+			sum_sq += dq[c] * dq[c];
+			uint8_t *out = &block[planes + (s * num_keys + k) * elem];
+			if (elem == 1) {
+				*out = (uint8_t)qv;
+			}
+			else {
+				const uint16_t qv16 = (uint16_t)qv;
+				memcpy(out, &qv16, sizeof(uint16_t));
+			}
+			s++;
+		}
+		dq[largest[k]] = sqrt(std::max(1.f - sum_sq, 0.f));
+		// rotation angle between unit quaternions: 4 * asin(|q - dq| / 2)
+		// (acos of the dot product is too coarse for sub-0.1 degree errors)
+		const float *q = &quats[4 * k];
+		double q_len = 0.0, dq_len = 0.0, dist_sq = 0.0;
+		for (uint8_t c = 0; c < 4; c++) {
+			q_len += (double)q[c] * q[c];
+			dq_len += (double)dq[c] * dq[c];
+		}
+		q_len = sqrt(q_len);
+		dq_len = sqrt(dq_len);
+		for (uint8_t c = 0; c < 4; c++) {
+			const double d = q[c] / q_len - dq[c] / dq_len;
+			dist_sq += d * d;
+		}
+		const double half_dist = std::min(sqrt(dist_sq) * 0.5, 1.0);
+		rot_err = std::max(rot_err,
+						   (float)(4.0 * asin(half_dist) * 57.29577951308232));
+
+		for (unsigned c = 0; c < 3; c++) {
+			const float val = track[(3 + c) * num_keys + k];
+			const uint32_t qv = quantize(val, range.pos_min[c],
+										 range.pos_extent[c], max_q);
+			const float dv = dequantize(qv, range.pos_min[c],
+										range.pos_extent[c], max_q);
+			pos_err = std::max(pos_err, fabs(dv - val));
+			uint8_t *out = &block[planes + ((3 + c) * num_keys + k) * elem];
+			if (elem == 1) {
+				*out = (uint8_t)qv;
+			}
+			else {
+				const uint16_t qv16 = (uint16_t)qv;
+				memcpy(out, &qv16, sizeof(uint16_t));
+			}
+		}
 	}
-}
\ No newline at end of file
+}
+
+} // namespace
+
+/// \brief Export animation to binary DDA layout specified by DD_Binary.h
+void AssetFBX::exportAnimationBinary()
+{
+	for(unsigned i = 0; i < m_clips.size(); i++) {
+		AnimClipFBX& _c = m_clips[i];
+		cbuff<512> buff512;
+		buff512.format("%s%s_%u.ddab",  m_fbxPath.str(), m_fbxName.str(), i);
+		std::fstream outfile;
+		outfile.open(buff512.str(), std::ios::out | std::ios::binary);
+
+		// check file is open
+		if (!outfile.is_open()) {
+			printf("Could not open binary animation output file\n");
+			m_exportFailed = true;
+			return;
+		}
+
+		const uint32_t num_frames = _c.m_frames;
+
+		DDAHeader header;
+		memset(&header, 0, sizeof(DDAHeader));
+		memcpy(header.magic, "DDAB", 4);
+		header.version = DDA_BIN_VERSION;
+		header.num_joints = _c.m_joints;
+		header.num_frames = num_frames;
+		header.framerate = _c.m_framerate;
+		header.repeat = 0;
+		header.flags = _c.isReduced() ? DDA_FLAG_KEYED : 0;
+		if (m_quantBits > 0) {
+			header.flags |= DDA_FLAG_QUANTIZED;
+			header.quant_bits = m_quantBits;
+		}
+		header.joint_offset = ddBinAlign(sizeof(DDAHeader));
+
+		dd_array<DDAJoint> joint_table(_c.m_joints);
+		uint64_t offset = ddBinAlign(header.joint_offset +
+									 _c.m_joints * sizeof(DDAJoint));
+		uint32_t max_keys = 0;
+		for (unsigned j = 0; j < _c.m_joints; j++) {
+			joint_table[j].joint_idx = j;
+			joint_table[j].num_keys = _c.numKeys(j);
+			joint_table[j].offset = offset;
+			offset += ddaTrackBlockSize(header, joint_table[j]);
+			max_keys = std::max(max_keys, joint_table[j].num_keys);
+		}
+
+		// blend shape weight table followed by one weight plane per shape
+		header.num_shapes = _c.m_numShapes;
+		dd_array<DDAShape> shape_table(_c.m_numShapes);
+		if (header.num_shapes > 0) {
+			header.shape_offset = offset;
+			offset = ddBinAlign(offset + header.num_shapes * sizeof(DDAShape));
+		}
+		for (unsigned s = 0; s < _c.m_numShapes; s++) {
+			memset(&shape_table[s], 0, sizeof(DDAShape));
+			snprintf(shape_table[s].id, sizeof(shape_table[s].id), "%s",
+					 _c.m_shapeIds[s].str());
+			shape_table[s].offset = offset;
+			offset = ddBinAlign(offset + (uint64_t)num_frames * sizeof(float));
+		}
+
+		outfile.write((const char*)&header, sizeof(DDAHeader));
+		if (joint_table.isValid()) {
+			outfile.write((const char*)&joint_table[0], joint_table.sizeInBytes());
+		}
+
+		// transpose frame-major samples into one contiguous block per joint
+		dd_scratch_array<uint32_t> key_frames(max_keys);
+		dd_scratch_array<float> track(6 * max_keys);
+		dd_array<uint8_t> quant_block;
+		float clip_rot_err = 0.f, clip_pos_err = 0.f;
+		for(unsigned j = 0; j < _c.m_joints; j++) {
+			const char zeros[DD_BIN_ALIGN] = {};
+			const uint32_t num_keys = joint_table[j].num_keys;
+			uint64_t pos = (uint64_t)outfile.tellp();
+			outfile.write(zeros, (std::streamsize)(joint_table[j].offset - pos));
+
+			for(unsigned k = 0; k < num_keys; k++) {
+				key_frames[k] = _c.keyFrame(j, k);
+				const AnimSample& _s = _c.sample(key_frames[k], j);
+				track[k] = _s.rot.x();
+				track[num_keys + k] = _s.rot.y();
+				track[2 * num_keys + k] = _s.rot.z();
+				track[3 * num_keys + k] = _s.pos.x() * scale_factor;
+				track[4 * num_keys + k] = _s.pos.y() * scale_factor;
+				track[5 * num_keys + k] = _s.pos.z() * scale_factor;
+			}
+			if (num_keys == 0) {
+				continue;
+			}
+			if (header.flags & DDA_FLAG_KEYED) {
+				outfile.write((const char*)&key_frames[0],
+							  num_keys * sizeof(uint32_t));
+				pos = (uint64_t)outfile.tellp();
+				const uint64_t planes = joint_table[j].offset +
+					ddaKeyBlockSize(header, joint_table[j]);
+				outfile.write(zeros, (std::streamsize)(planes - pos));
+			}
+			if (header.flags & DDA_FLAG_QUANTIZED) {
+				float rot_err = 0.f, pos_err = 0.f;
+				quantizeJointTrack(&track[0], num_keys, m_quantBits, quant_block,
+								   rot_err, pos_err);
+				outfile.write((const char*)&quant_block[0],
+							  quant_block.sizeInBytes());
+				printf("\tjoint %3u: max error rot %.5f(deg) pos %.5f\n",
+					   j, rot_err, pos_err);
+				clip_rot_err = std::max(clip_rot_err, rot_err);
+				clip_pos_err = std::max(clip_pos_err, pos_err);
+				continue;
+			}
+			outfile.write((const char*)&track[0], 6 * num_keys * sizeof(float));
+		}
+		const char zeros[DD_BIN_ALIGN] = {};
+		auto padTo = [&](const uint64_t target) {
+			const uint64_t pos = (uint64_t)outfile.tellp();
+			if (target > pos) {
+				outfile.write(zeros, (std::streamsize)(target - pos));
+			}
+		};
+		if (shape_table.isValid()) {
+			padTo(header.shape_offset);
+			outfile.write((const char*)&shape_table[0], shape_table.sizeInBytes());
+		}
+		for (unsigned s = 0; s < _c.m_numShapes && num_frames > 0; s++) {
+			padTo(shape_table[s].offset);
+			outfile.write((const char*)&_c.m_shapeWeights[(size_t)s * num_frames],
+						  num_frames * sizeof(float));
+		}
+		padTo(offset);
+		printf("Binary animation: %s (%u joints, %u shapes, %u frames, "
+			   "%llu bytes)\n",
+			   buff512.str(), _c.m_joints, _c.m_numShapes, num_frames,
+			   (unsigned long long)outfile.tellp());
+		if (header.flags & DDA_FLAG_QUANTIZED) {
+			printf("Quantized %u-bit tracks: max error rot %.5f(deg) pos %.5f\n",
+				   m_quantBits, clip_rot_err, clip_pos_err);
+		}
+		outfile.close();
+		checkWrite(outfile.fail(), buff512.str());
+	}
+}
@@ -0,0 +1,422 @@
+#include "FBX_Writer.h"
+#include <cmath>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <algorithm>
+#ifdef DD_USE_ZLIB
+#include <zlib.h>
+#endif // DD_USE_ZLIB
+#ifdef DD_USE_ZSTD
+#include <zstd.h>
+#endif // DD_USE_ZSTD
+
+#define TEXT_WRITER_MAX_NUMBER 64	// longest "%.3f" float is 47 chars
+
+TextWriterFBX::TextWriterFBX() :
+	m_file(nullptr),
+	m_data(nullptr),
+	m_fill(0),
+	m_used(0),
+	m_written(0),
+	m_fileBytes(0),
+	m_mode(TextCompression::NONE),
+	m_stream(nullptr),
+	m_pending(nullptr),
+	m_pendingSize(0),
+	m_hasPending(false),
+	m_finish(false),
+	m_failed(false)
+{
+	m_buffers[0].resizeUninit(TEXT_WRITER_BUFFER_SIZE);
+	m_data = &m_buffers[0][0];
+}
+
+TextWriterFBX::~TextWriterFBX()
+{
+	close();
+}
+
+bool TextWriterFBX::supports(const TextCompression mode)
+{
+	switch (mode) {
+		case TextCompression::GZIP:
+#ifdef DD_USE_ZLIB
+			return true;
+#else
+			return false;
+#endif // DD_USE_ZLIB
+		case TextCompression::ZSTD:
+#ifdef DD_USE_ZSTD
+			return true;
+#else
+			return false;
+#endif // DD_USE_ZSTD
+		default:
+			return true;
+	}
+}
+
+const char* TextWriterFBX::extension(const TextCompression mode)
+{
+	switch (mode) {
+		case TextCompression::GZIP:
+			return ".gz";
+		case TextCompression::ZSTD:
+			return ".zst";
+		default:
+			return "";
+	}
+}
+
+bool TextWriterFBX::open(const char* fileName,
+						 const TextCompression mode,
+						 const int level)
+{
+	close();
+	if (!supports(mode)) {
+		printf("Compressed output not supported by this build\n");
+		return false;
+	}
+	std::string path = std::string(fileName) + extension(mode);
+	// plain text keeps text mode to match the previous fstream output (CRLF
+	// on windows)
+	m_file = fopen(path.c_str(), (mode == TextCompression::NONE) ? "w" : "wb");
+	if (!m_file) {
+		return false;
+	}
+	// the writer buffers itself: chunks go straight to write()
+	setvbuf(m_file, nullptr, _IONBF, 0);
+	m_fill = 0;
+	m_data = &m_buffers[0][0];
+	m_used = 0;
+	m_written = 0;
+	m_fileBytes = 0;
+	m_failed = false;
+	m_mode = mode;
+	if (m_mode == TextCompression::NONE) {
+		return true;
+	}
+
+	if (!m_buffers[1].isValid()) {
+		m_buffers[1].resizeUninit(TEXT_WRITER_BUFFER_SIZE);
+		m_out.resizeUninit(TEXT_WRITER_BUFFER_SIZE);
+	}
+#ifdef DD_USE_ZLIB
+	if (m_mode == TextCompression::GZIP) {
+		z_stream* zs = new z_stream();
+		// 15 + 16: 32K window w/ gzip header and trailer
+		if (deflateInit2(zs, (level < 0) ? Z_DEFAULT_COMPRESSION : level,
+						 Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			delete zs;
+			fclose(m_file);
+			m_file = nullptr;
+			return false;
+		}
+		m_stream = zs;
+	}
+#endif // DD_USE_ZLIB
+#ifdef DD_USE_ZSTD
+	if (m_mode == TextCompression::ZSTD) {
+		ZSTD_CCtx* cctx = ZSTD_createCCtx();
+		if (!cctx || ZSTD_isError(ZSTD_CCtx_setParameter(
+				cctx, ZSTD_c_compressionLevel,
+				(level < 0) ? ZSTD_CLEVEL_DEFAULT : level))) {
+			printf("zstd: could not create compression context\n");
+			ZSTD_freeCCtx(cctx);
+			fclose(m_file);
+			m_file = nullptr;
+			return false;
+		}
+		m_stream = cctx;
+	}
+#endif // DD_USE_ZSTD
+	m_hasPending = false;
+	m_finish = false;
+	m_worker = std::thread(&TextWriterFBX::compressLoop, this);
+	return true;
+}
+
+void TextWriterFBX::close()
+{
+	if (!m_file) {
+		return;
+	}
+	flush();
+	if (m_mode != TextCompression::NONE) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_finish = true;
+		}
+		m_cond.notify_all();
+		m_worker.join();
+#ifdef DD_USE_ZLIB
+		if (m_mode == TextCompression::GZIP) {
+			deflateEnd((z_stream*)m_stream);
+			delete (z_stream*)m_stream;
+		}
+#endif // DD_USE_ZLIB
+#ifdef DD_USE_ZSTD
+		if (m_mode == TextCompression::ZSTD) {
+			ZSTD_freeCCtx((ZSTD_CCtx*)m_stream);
+		}
+#endif // DD_USE_ZSTD
+		m_stream = nullptr;
+	}
+	if (fclose(m_file) != 0 && !m_failed) {
+		printf("Write failed: %s\n", strerror(errno));
+		m_failed = true;
+	}
+	m_file = nullptr;
+}
+
+void TextWriterFBX::flush()
+{
+	if (!m_file || m_used == 0) {
+		m_written += m_used;
+		m_used = 0;
+		return;
+	}
+	if (m_mode == TextCompression::NONE) {
+		writeChunk(m_data, m_used, false);
+	}
+	else {
+		// hand the full buffer to the compressor and keep filling the other
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_cond.wait(lock, [this]() { return !m_hasPending; });
+		m_pending = m_data;
+		m_pendingSize = m_used;
+		m_hasPending = true;
+		lock.unlock();
+		m_cond.notify_all();
+		m_fill ^= 1;
+		m_data = &m_buffers[m_fill][0];
+	}
+	m_written += m_used;
+	m_used = 0;
+}
+
+void TextWriterFBX::compressLoop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true) {
+		m_cond.wait(lock, [this]() { return m_hasPending || m_finish; });
+		if (m_hasPending) {
+			lock.unlock();
+			writeChunk(m_pending, m_pendingSize, false);
+			lock.lock();
+			m_hasPending = false;
+			m_cond.notify_all();
+			continue;
+		}
+		break;
+	}
+	lock.unlock();
+	writeChunk(nullptr, 0, true);
+}
+
+void TextWriterFBX::writeChunk(const char* data,
+							   const size_t size,
+							   const bool finish)
+{
+	switch (m_mode) {
+#ifdef DD_USE_ZLIB
+		case TextCompression::GZIP: {
+			z_stream* zs = (z_stream*)m_stream;
+			zs->next_in = (Bytef*)data;
+			zs->avail_in = (uInt)size;
+			do {
+				zs->next_out = (Bytef*)&m_out[0];
+				zs->avail_out = (uInt)m_out.size();
+				const int result = deflate(zs, finish ? Z_FINISH : Z_NO_FLUSH);
+				// Z_BUF_ERROR is only an error while there is work left (an
+				// empty call w/ no input is harmless)
+				if (result == Z_STREAM_ERROR ||
+					(result == Z_BUF_ERROR && (zs->avail_in > 0 || finish))) {
+					printf("deflate failed (%d)\n", result);
+					m_failed = true;
+					return;
+				}
+				writeOut(&m_out[0], m_out.size() - zs->avail_out);
+			} while (zs->avail_out == 0);
+			break;
+		}
+#endif // DD_USE_ZLIB
+#ifdef DD_USE_ZSTD
+		case TextCompression::ZSTD: {
+			ZSTD_inBuffer input = { data, size, 0 };
+			bool done = false;
+			while (!done) {
+				ZSTD_outBuffer output = { &m_out[0], m_out.size(), 0 };
+				const size_t remaining = ZSTD_compressStream2(
+					(ZSTD_CCtx*)m_stream, &output, &input,
+					finish ? ZSTD_e_end : ZSTD_e_continue);
+				if (ZSTD_isError(remaining)) {
+					printf("zstd: %s\n", ZSTD_getErrorName(remaining));
+					m_failed = true;
+					return;
+				}
+				writeOut(&m_out[0], output.pos);
+				done = finish ? (remaining == 0) : (input.pos == input.size);
+			}
+			break;
+		}
+#endif // DD_USE_ZSTD
+		default:
+			writeOut(data, size);
+			break;
+	}
+}
+
+void TextWriterFBX::writeOut(const void* data, const size_t size)
+{
+	if (m_failed || size == 0) {
+		return;
+	}
+	const size_t written = fwrite(data, 1, size, m_file);
+	m_fileBytes += written;
+	if (written != size) {
+		// report once (disk full, I/O error), the rest of the stream is dropped
+		printf("Write failed: %s\n", strerror(errno));
+		m_failed = true;
+	}
+}
+
+void TextWriterFBX::put(const char* str)
+{
+	size_t len = strlen(str);
+	while (len > 0) {
+		reserve(1);
+		const size_t count = std::min(len, TEXT_WRITER_BUFFER_SIZE - m_used);
+		memcpy(m_data + m_used, str, count);
+		m_used += count;
+		str += count;
+		len -= count;
+	}
+}
+
+void TextWriterFBX::put(const char c)
+{
+	reserve(1);
+	m_data[m_used++] = c;
+}
+
+void TextWriterFBX::putUint(uint64_t val)
+{
+	reserve(TEXT_WRITER_MAX_NUMBER);
+	char digits[24];
+	int count = 0;
+	do {
+		digits[count++] = (char)('0' + val % 10);
+		val /= 10;
+	} while (val);
+	while (count) {
+		m_data[m_used++] = digits[--count];
+	}
+}
+
+void TextWriterFBX::putFloat(const float val)
+{
+	reserve(TEXT_WRITER_MAX_NUMBER);
+	// float * 1000 needs at most 24 + 7 significant bits so the product is
+	// exact in double and rounding it (ties to even) matches printf
+	const double scaled = fabs((double)val) * 1000.0;
+	if (!(scaled < 1e18)) { // huge, inf or nan
+		m_used += snprintf(&m_data[m_used], TEXT_WRITER_MAX_NUMBER, "%.3f",
+						   val);
+		return;
+	}
+	const uint64_t fixed = (uint64_t)nearbyint(scaled);
+	if (std::signbit(val)) {
+		m_data[m_used++] = '-';
+	}
+	putUint(fixed / 1000);
+	const unsigned frac = (unsigned)(fixed % 1000);
+	m_data[m_used++] = '.';
+	m_data[m_used++] = (char)('0' + frac / 100);
+	m_data[m_used++] = (char)('0' + (frac / 10) % 10);
+	m_data[m_used++] = (char)('0' + frac % 10);
+}
+
+void TextWriterFBX::floatLine(const char* tag, const float a)
+{
+	put(tag);
+	put(' ');
+	putFloat(a);
+	put('\n');
+}
+
+void TextWriterFBX::floatLine(const char* tag, const float a, const float b)
+{
+	put(tag);
+	put(' ');
+	putFloat(a);
+	put(' ');
+	putFloat(b);
+	put('\n');
+}
+
+void TextWriterFBX::floatLine(const char* tag, const float a, const float b,
+							  const float c)
+{
+	put(tag);
+	put(' ');
+	putFloat(a);
+	put(' ');
+	putFloat(b);
+	put(' ');
+	putFloat(c);
+	put('\n');
+}
+
+void TextWriterFBX::floatLine(const char* tag, const float a, const float b,
+							  const float c, const float d)
+{
+	put(tag);
+	put(' ');
+	putFloat(a);
+	put(' ');
+	putFloat(b);
+	put(' ');
+	putFloat(c);
+	put(' ');
+	putFloat(d);
+	put('\n');
+}
+
+void TextWriterFBX::uintLine(const char* tag, const uint64_t a)
+{
+	put(tag);
+	put(' ');
+	putUint(a);
+	put('\n');
+}
+
+void TextWriterFBX::uintLine(const char* tag, const uint64_t a,
+							 const uint64_t b, const uint64_t c)
+{
+	put(tag);
+	put(' ');
+	putUint(a);
+	put(' ');
+	putUint(b);
+	put(' ');
+	putUint(c);
+	put('\n');
+}
+
+void TextWriterFBX::uintLine(const char* tag, const uint64_t a,
+							 const uint64_t b, const uint64_t c,
+							 const uint64_t d)
+{
+	put(tag);
+	put(' ');
+	putUint(a);
+	put(' ');
+	putUint(b);
+	put(' ');
+	putUint(c);
+	put(' ');
+	putUint(d);
+	put('\n');
+}
@@ -1,9 +1,32 @@
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <string>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <tuple>
+#include <unordered_map>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <glob.h>
+#include <sys/resource.h>
+#endif // _WIN32
 
 #include "FBX_Utility.h"
 #include "FBX_MeshFuncs.h"
+#include "FBX_Stream.h"
+#include "FBX_Archive.h"
 
 #include <fbxsdk.h>
 
@@ -14,7 +37,13 @@ enum class ExportArg
 	ANIMATION = 0x2,
 	SKELETON = 0x4,
 	VICON = 0x8,
-	SCALE = 0x10
+	SCALE = 0x10,
+	MESH_BIN = 0x20,
+	ANIMATION_BIN = 0x40,
+	WELD = 0x80,
+	VCACHE = 0x100,
+	PARALLEL = 0x200,
+	SKELETON_BIN = 0x400
 };
 template<>
 struct EnableBitMaskOperators<ExportArg> { static const bool enable = true; };
@@ -29,18 +58,42 @@ ExportArg checkArgs(const char* arg)
 				bitflag |= ExportArg::MESH;
 				printf("Mesh out\n");
 				break;
+			case 'M':
+				bitflag |= ExportArg::MESH_BIN;
+				printf("Binary mesh out\n");
+				break;
 			case 'a':
 				bitflag |= ExportArg::ANIMATION;
 				printf("Animation out\n");
 				break;
+			case 'A':
+				bitflag |= ExportArg::ANIMATION_BIN;
+				printf("Binary animation out\n");
+				break;
 			case 's':
 				bitflag |= ExportArg::SKELETON;
 				printf("Skeleton out\n");
 				break;
+			case 'B':
+				bitflag |= ExportArg::SKELETON_BIN;
+				printf("Binary skeleton out\n");
+				break;
 			case 'v':
 				bitflag |= ExportArg::VICON;
 				printf("Vicon format\n");
 				break;
+			case 'w':
+				bitflag |= ExportArg::WELD;
+				printf("Weld vertices\n");
+				break;
+			case 'o':
+				bitflag |= ExportArg::VCACHE;
+				printf("Optimize vertex cache\n");
+				break;
+			case 'p':
+				bitflag |= ExportArg::PARALLEL;
+				printf("Parallel animation sampling\n");
+				break;
 			default:
 				break;
 		}
@@ -49,20 +102,97 @@ ExportArg checkArgs(const char* arg)
 	return bitflag;
 }
 
+/// \brief Returns value of "--name=value" argument (nullptr if not a match)
+const char* checkOption(const char* arg, const char* name)
+{
+	const size_t len = strlen(name);
+	if (strncmp(arg, "--", 2) == 0 && strncmp(arg + 2, name, len) == 0 &&
+		arg[len + 2] == '=') {
+		return arg + len + 3;
+	}
+	return nullptr;
+}
+
 FbxNode* FindAttribute(FbxNode *_node, const FbxNodeAttribute::EType type);
 
 FbxNode* FindAttributeParent(FbxNode *_node, const FbxNodeAttribute::EType type);
 
+/// \brief Export settings shared by every file converted in a run
+struct ConvertArgs
+{
+	ExportArg flags = ExportArg::NONE;
+	float scale_factor = 1.f;
+	float weld_eps = 0.f;
+	bool curve_sampler = false;
+	float pos_tolerance = -1.f;
+	float rot_tolerance = -1.f;
+	uint32_t quant_bits = 0;
+	TextCompression compression = TextCompression::NONE;
+	int compress_level = -1;
+	uint32_t max_influences = MAX_INFLUENCES;
+	uint32_t weight_bits = 0;
+	float shape_eps = 1e-5f;
+};
+
+/// \brief Per-file batch result
+struct ConvertResult
+{
+	std::string file;
+	double size_mb = 0.0;
+	double import_ms = 0.0;
+	double time_ms = 0.0;
+	bool success = false;
+};
+
+std::string setupImportProfile(FbxManager* sdkManager, const ExportArg flags);
+double peakRssMB();
+bool convertFbx(FbxManager* sdkManager, const std::string& fileProvided,
+				const ConvertArgs& args, MemStreamFBX* stream = nullptr,
+				double* import_ms = nullptr);
+/// \brief One fbx input: a file on disk or an entry of a zip archive
+struct InputFbx
+{
+	std::string file;	// fbx file or zip archive
+	std::string entry;	// archive entry (empty for plain files)
+};
+
+std::vector<InputFbx> gatherBatchFiles(const std::string& input);
+void runBatch(const std::vector<InputFbx>& files, const ConvertArgs& args,
+			  unsigned num_jobs);
+static bool isArchiveFile(const std::string& file);
+static void gatherArchiveFiles(const std::string& archive,
+							   std::vector<InputFbx>& out);
+
 int main(const int argc, const char** argv)
 {
-	const char* help = "\nProvide fbx file and arguments for export: "
+	const char* help = "\nProvide fbx file (or .zip of fbx files) and arguments"
+		" for export: "
 		"\n\t-m\tmesh"
+		"\n\t-M\tbinary mesh (mmap-able .ddmb)"
 		"\n\t-a\tanimation"
+		"\n\t-A\tbinary animation (per-joint tracks .ddab)"
 		"\n\t-s\tskeleton"
+		"\n\t-B\tbinary skeleton w/ inverse bind matrices (.ddbb)"
 		"\n\t~<float>\tadjust export scale"
-		"\n\t-v\tvicon\n";
-	ExportArg exportFlags = ExportArg::NONE;
-	float scale_factor = 1.f;
+		"\n\t-v\tvicon"
+		"\n\t-w\tweld identical vertices"
+		"\n\t-o\toptimize index order for vertex cache"
+		"\n\t-p\tsample animation joints in parallel (OpenMP)"
+		"\n\t--weld=<float>\tweld vertices within epsilon"
+		"\n\t--ktol-pos=<float>\tkeyframe reduction position tolerance (cm)"
+		"\n\t--ktol-rot=<float>\tkeyframe reduction rotation tolerance (deg)"
+		"\n\t--quant=<4-16>\tquantize binary animation tracks to n-bit keys (0: off)"
+		"\n\t--influences=<1-4>\tskin weights kept per vertex (default: 4)"
+		"\n\t--weight-bits=<0|8|16>\tstore skin weights as n-bit unorm (binary ddm, 0: float)"
+		"\n\t--shape-eps=<float>\tdrop blend shape deltas within epsilon"
+		"\n\t--compress=<gz|zst>\tcompress text ddm/ddb/dda output"
+		"\n\t--compress-level=<int>\tgz 1-9 / zst 1-22 (default: library)"
+		"\n\t--sampler=<frame|curve>\tanimation sampling path (timed)"
+		"\n\t--batch=<dir|glob|manifest>\tconvert many fbx (or .zip) files"
+		"\n\t--jobs=<int>\tbatch worker threads (default: all cores)\n";
+	ConvertArgs args;
+	std::string batch_input;
+	unsigned num_jobs = 0;
 
 	std::string fbx_to_read;
 	if( argc < 3 ) {
@@ -71,14 +201,82 @@ int main(const int argc, const char** argv)
 	}
 	else {
 		for (int i = 1; i < argc; i++) {
-			if (*argv[i] == '-') {					// parse args		
-				exportFlags |= checkArgs(argv[i]);
+			const char* opt = nullptr;
+			if ((opt = checkOption(argv[i], "weld"))) {	// weld epsilon
+				args.weld_eps = strtof(opt, nullptr);
+				args.flags |= ExportArg::WELD;
+			}
+			else if ((opt = checkOption(argv[i], "ktol-pos"))) {	// key reduction
+				args.pos_tolerance = strtof(opt, nullptr);
+			}
+			else if ((opt = checkOption(argv[i], "ktol-rot"))) {
+				args.rot_tolerance = strtof(opt, nullptr);
+			}
+			else if ((opt = checkOption(argv[i], "quant"))) {	// track bits
+				// 0 turns quantization off, other values clamp to 4-16 bits
+				const unsigned long bits = strtoul(opt, nullptr, 10);
+				args.quant_bits =
+					bits ? (uint32_t)std::min(std::max(bits, 4ul), 16ul) : 0;
+				if (args.quant_bits) {
+					printf("Quantize binary animation tracks: %u-bit\n",
+						   args.quant_bits);
+				}
+			}
+			else if ((opt = checkOption(argv[i], "influences"))) {	// top-k skin
+				const unsigned long k = strtoul(opt, nullptr, 10);
+				args.max_influences =
+					(uint32_t)std::min(std::max(k, 1ul), (unsigned long)MAX_INFLUENCES);
+			}
+			else if ((opt = checkOption(argv[i], "weight-bits"))) {	// unorm weights
+				// 0 keeps float weights
+				if (strcmp(opt, "0") == 0 || strcmp(opt, "8") == 0 ||
+					strcmp(opt, "16") == 0) {
+					args.weight_bits = (uint32_t)strtoul(opt, nullptr, 10);
+				}
+				else {
+					printf("Unsupported weight bits: %s (use 0, 8 or 16)\n", opt);
+					return -1;
+				}
+			}
+			else if ((opt = checkOption(argv[i], "shape-eps"))) {	// sparse shapes
+				args.shape_eps = std::max(strtof(opt, nullptr), 0.f);
+			}
+			else if ((opt = checkOption(argv[i], "compress"))) {	// text output
+				if (strcmp(opt, "gz") == 0) {
+					args.compression = TextCompression::GZIP;
+				}
+				else if (strcmp(opt, "zst") == 0 || strcmp(opt, "zstd") == 0) {
+					args.compression = TextCompression::ZSTD;
+				}
+				else {
+					printf("Unknown compression format: %s (use gz or zst)\n", opt);
+					return -1;
+				}
+				if (!TextWriterFBX::supports(args.compression)) {
+					printf("%s compression not available in this build\n", opt);
+					args.compression = TextCompression::NONE;
+				}
+			}
+			else if ((opt = checkOption(argv[i], "compress-level"))) {
+				args.compress_level = (int)strtol(opt, nullptr, 10);
+			}
+			else if ((opt = checkOption(argv[i], "sampler"))) {	// anim sampler
+				args.curve_sampler = strcmp(opt, "curve") == 0;
+			}
+			else if ((opt = checkOption(argv[i], "batch"))) {	// batch input
+				batch_input = opt;
+			}
+			else if ((opt = checkOption(argv[i], "jobs"))) {	// worker count
+				num_jobs = (unsigned)strtoul(opt, nullptr, 10);
+			}
+			else if (*argv[i] == '-') {					// parse args		
+				args.flags |= checkArgs(argv[i]);
 			}
 			else if (*argv[i] == '~') {				// scale skeleton and animations		
 				dd_array<cbuff<8>> sc = StrSpace::tokenize512<8>(argv[i], "~");
 				for (size_t j = 0; j < sc.size(); j++) {
 					if (*sc[j].str() && *sc[j].str() != ' ') {
-						scale_factor = strtof(sc[j].str(), nullptr);
+						args.scale_factor = strtof(sc[j].str(), nullptr);
 					}
 				}
 			}
@@ -87,17 +285,123 @@ int main(const int argc, const char** argv)
 			}
 		}
 	}
+
+	printf("Import profile: %s\n",
+		   setupImportProfile(nullptr, args.flags).c_str());
+
+	if (!batch_input.empty() || isArchiveFile(fbx_to_read)) {
+		std::vector<InputFbx> files;
+		if (batch_input.empty()) {
+			batch_input = fbx_to_read;
+			gatherArchiveFiles(fbx_to_read, files);
+		}
+		else {
+			files = gatherBatchFiles(batch_input);
+		}
+		if (files.empty()) {
+			printf("No FBX files found in %s\n", batch_input.c_str());
+			exit(-1);
+		}
+		runBatch(files, args, num_jobs);
+		return 0;
+	}
+
 	// create fbx manager object
 	FbxManager* sdkManager = FbxManager::Create();
 
 	// initialize settings
-	FbxIOSettings *_IOSettings = FbxIOSettings::Create(sdkManager, IOSROOT);
-	sdkManager->SetIOSettings(_IOSettings);
+	setupImportProfile(sdkManager, args.flags);
+
+	const bool success = convertFbx(sdkManager, fbx_to_read, args);
+
+	// destroy sdkManager when done
+	sdkManager->Destroy();
+
+	return success ? 0 : -1;
+}
+
+/// \brief Create import settings that only load the scene data the export
+/// flags use (returns profile description)
+/// \param sdkManager FbxManager to attach settings to (nullptr: describe only)
+/// \param flags export flags of the run
+std::string setupImportProfile(FbxManager* sdkManager, const ExportArg flags)
+{
+	const bool mesh = bool(flags & (ExportArg::MESH | ExportArg::MESH_BIN));
+	const bool skeleton =
+		bool(flags & (ExportArg::SKELETON | ExportArg::SKELETON_BIN));
+	const bool anim =
+		bool(flags & (ExportArg::ANIMATION | ExportArg::ANIMATION_BIN));
+
+	std::string profile;
+	profile += mesh ? "mesh " : "";
+	profile += skeleton ? "skeleton " : "";
+	profile += anim ? "animation " : "";
+	profile = profile.empty() ? "hierarchy" : profile.substr(0, profile.size() - 1);
+	profile += " (skip:";
+	profile += mesh ? "" : " materials textures";
+	profile += (mesh || skeleton) ? "" : " skins";
+	profile += anim ? "" : " animation";
+	profile += (mesh || anim) ? "" : " shapes";
+	profile += " lights cameras constraints)";
+
+	if (sdkManager) {
+		FbxIOSettings *_IOSettings = FbxIOSettings::Create(sdkManager, IOSROOT);
+		// joints and meshes are both models so the node hierarchy always loads
+		_IOSettings->SetBoolProp(IMP_FBX_MODEL, true);
+		_IOSettings->SetBoolProp(IMP_FBX_MATERIAL, mesh);
+		_IOSettings->SetBoolProp(IMP_FBX_TEXTURE, mesh);
+		// skin clusters carry vertex weights and the skeleton bind pose
+		_IOSettings->SetBoolProp(IMP_FBX_LINK, mesh || skeleton);
+		_IOSettings->SetBoolProp(IMP_FBX_ANIMATION, anim);
+		// blend shape targets (mesh deltas) and their weight curves
+		_IOSettings->SetBoolProp(IMP_FBX_SHAPE, mesh || anim);
+		_IOSettings->SetBoolProp(IMP_FBX_GOBO, false);
+		_IOSettings->SetBoolProp(IMP_FBX_CHARACTER, false);
+		_IOSettings->SetBoolProp(IMP_FBX_CONSTRAINT, false);
+		_IOSettings->SetBoolProp(IMP_FBX_EXTRACT_EMBEDDED_DATA, false);
+		_IOSettings->SetBoolProp(IMP_LIGHT, false);
+		_IOSettings->SetBoolProp(IMP_CAMERA, false);
+		sdkManager->SetIOSettings(_IOSettings);
+	}
+	return profile;
+}
+
+/// \brief Peak resident set size of the process in MB
+double peakRssMB()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return (double)counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+	}
+	return 0.0;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0.0;
+	}
+#ifdef __APPLE__
+	return (double)usage.ru_maxrss / (1024.0 * 1024.0);	// bytes
+#else
+	return (double)usage.ru_maxrss / 1024.0;				// kilobytes
+#endif // __APPLE__
+#endif // _WIN32
+}
+
+/// \brief Import one fbx file into a new scene and export requested assets
+/// \param sdkManager FbxManager owned by the calling thread
+/// \param fileProvided path to fbx file
+/// \param args export settings
+/// \param stream optional mapped / in-memory fbx data (file is mapped if null)
+/// \param import_ms optional output of scene import time
+bool convertFbx(FbxManager* sdkManager, const std::string& fileProvided,
+				const ConvertArgs& args, MemStreamFBX* stream, double* import_ms)
+{
+	const ExportArg exportFlags = args.flags;
 
 	// process input
 	std::string fbx_path;
 	std::string fbx_name;
-	std::string fileProvided = fbx_to_read.c_str();
 	size_t filePath = fileProvided.find_last_of("/\\");
 	if (filePath != std::string::npos) {
 		fbx_path = fileProvided.substr(0, filePath + 1).c_str();
@@ -106,7 +410,7 @@ int main(const int argc, const char** argv)
 	size_t fileExtIndex = fileProvided.find_last_of('.');
 	if (fileExtIndex == std::string::npos || fileProvided == "") {
 		printf("Provide valid FBX file\n");
-		exit(-1);
+		return false;
 	}
 
 	std::string fileExt = fileProvided.substr(fileExtIndex + 1);
@@ -117,18 +421,37 @@ int main(const int argc, const char** argv)
 	}
 	else {
 		printf("Invalid FBX file\n");
-		exit(-1);
+		return false;
 	}
 
 	// Create importer
+	auto import_start = std::chrono::high_resolution_clock::now();
 	FbxImporter* _importer = FbxImporter::Create(sdkManager, "");
 
-	// initialize fbx object
-	if (!_importer->Initialize(fileProvided.c_str(), -1,
-							   sdkManager->GetIOSettings())) {
+	// import from memory: mmap the file unless the caller provided the data
+	MemStreamFBX file_stream;
+	if (!stream) {
+		stream = &file_stream;
+		stream->mapFile(fileProvided.c_str());
+	}
+
+	// initialize fbx object (fall back to sdk file reads if mapping failed)
+	bool initialized = false;
+	if (stream->isValid()) {
+		stream->setReaderID(sdkManager);
+		initialized = _importer->Initialize(stream, nullptr,
+											stream->GetReaderID(),
+											sdkManager->GetIOSettings());
+	}
+	else {
+		initialized = _importer->Initialize(fileProvided.c_str(), -1,
+											sdkManager->GetIOSettings());
+	}
+	if (!initialized) {
 		printf("Call to FBX::Initialize() failed. \nError: %s\n\n",
 			   _importer->GetStatus().GetErrorString());
-		exit(-1);
+		_importer->Destroy();
+		return false;
 	}
 
 	// create scene for FBX file
@@ -137,6 +460,13 @@ int main(const int argc, const char** argv)
 	// destroy importer after importing scene
 	_importer->Import(fbx_scene);
 	_importer->Destroy();
+	auto import_end = std::chrono::high_resolution_clock::now();
+	const double import_time =
+		std::chrono::duration<double, std::milli>(import_end - import_start).count();
+	printf("Import: %.3f ms (peak RSS %.1f MB)\n", import_time, peakRssMB());
+	if (import_ms) {
+		*import_ms = import_time;
+	}
 	// get global time info
 	FbxTime::EMode g_timemode = fbx_scene->GetGlobalSettings().GetTimeMode();
 	const float fr_rate = FbxTime::GetFrameRate(g_timemode);
@@ -146,21 +476,50 @@ int main(const int argc, const char** argv)
 	FbxGeometryConverter lGeomConverter(sdkManager);
 	lGeomConverter.Triangulate(fbx_scene, true);
 
+	// per-asset scratch (pose store, curve bins, mesh scratch) is drawn from
+	// this thread's arena and dropped in one go once the asset is exported
+	static thread_local dd_arena scratch;
+
 	// recursively walk thru scene and get asset information
+	bool exported = true;
 	FbxNode* rootNode = fbx_scene->GetRootNode();
 	if (rootNode) {
+		dd_arena_scope scratch_scope(scratch);
 		// create asset
 		AssetFBX asset;
-		asset.scale_factor = scale_factor;
+		asset.scale_factor = args.scale_factor;
 		asset.m_fbxName.set(fbx_name.c_str());
 		asset.m_fbxPath.set(fbx_path.c_str());
 		if (bool(exportFlags & ExportArg::VICON)) {
 			asset.m_viconFormat = true;
 		}
+		if (bool(exportFlags & ExportArg::WELD)) {
+			asset.m_weldVerts = true;
+			asset.m_weldEpsilon = args.weld_eps;
+		}
+		if (bool(exportFlags & ExportArg::VCACHE)) {
+			asset.m_optimizeCache = true;
+		}
+		if (bool(exportFlags & ExportArg::PARALLEL)) {
+			asset.m_parallelSampling = true;
+		}
+		asset.m_curveSampler = args.curve_sampler;
+		asset.m_posTolerance = args.pos_tolerance;
+		asset.m_rotTolerance = args.rot_tolerance;
+		asset.m_quantBits = args.quant_bits;
+		asset.m_compression = args.compression;
+		asset.m_compressLevel = args.compress_level;
+		asset.m_maxInfluences = args.max_influences;
+		asset.m_weightBits = args.weight_bits;
+		asset.m_shapeEpsilon = args.shape_eps;
 		printf("\n\n---------\nSkeleton\n---------\n\n");
 		FbxNode *_node = FindAttribute(rootNode, fbxsdk::FbxNodeAttribute::eSkeleton);
 		if (_node) {
-			processSkeletonAsset(_node, 0, asset);
+			processSkeletonAsset(_node, MAX_JOINTS, asset);
+			// parents before children (skinning palette is one linear pass)
+			if (asset.m_skeleton.sortTopological()) {
+				printf("Joints reordered: parents before children\n");
+			}
 		}
 		printf("\n\n---------\nAnimation\n---------\n\n");
 		for (int i = 0; i < fbx_scene->GetSrcObjectCount<FbxAnimStack>(); i++) {
@@ -174,10 +533,16 @@ int main(const int argc, const char** argv)
 			if (bool(exportFlags & ExportArg::ANIMATION)) {
 				asset.exportAnimation();
 			}
+			if (bool(exportFlags & ExportArg::ANIMATION_BIN)) {
+				asset.exportAnimationBinary();
+			}
 		}
 		printf("\n\n----\nMesh\n----\n\n");
-		FbxNode *mesh_parent_node = 
-			FindAttributeParent(rootNode, fbxsdk::FbxNodeAttribute::eMesh);
+		// meshes are only walked for geometry or the skin cluster bind pose
+		const bool mesh_pass = bool(exportFlags & (ExportArg::MESH |
+			ExportArg::MESH_BIN | ExportArg::SKELETON | ExportArg::SKELETON_BIN));
+		FbxNode *mesh_parent_node = mesh_pass ?
+			FindAttributeParent(rootNode, fbxsdk::FbxNodeAttribute::eMesh) : nullptr;
 		if (mesh_parent_node) {
 			for (int i = 0; i < mesh_parent_node->GetChildCount(); i++) {
 				FbxNode *_node = mesh_parent_node->GetChild(i);
@@ -188,18 +553,285 @@ int main(const int argc, const char** argv)
 						processAsset(_node, 
 									asset, 
 									bool(exportFlags & ExportArg::SKELETON),
-									bool(exportFlags & ExportArg::MESH));
+									bool(exportFlags & ExportArg::MESH),
+									bool(exportFlags & ExportArg::MESH_BIN),
+									bool(exportFlags & ExportArg::SKELETON_BIN));
 					}
 				}
 			}
 		}
 		// end of parsing
+		printf("\nScratch arena peak: %.1f MB\n",
+			   (double)scratch.bytesPeak() / (1024.0 * 1024.0));
+		exported = !asset.m_exportFailed;
 	}
+	scratch.reset();
 
-	// destroy sdkManager when done
-	sdkManager->Destroy();
+	// release scene so the manager can be reused for the next file
+	fbx_scene->Destroy(true);
+	return exported;
+}
+
+/// \brief Check for .fbx/.FBX extension
+static bool isFbxFile(const std::string& file)
+{
+	const size_t ext = file.find_last_of('.');
+	if (ext == std::string::npos) {
+		return false;
+	}
+	const std::string fileExt = file.substr(ext + 1);
+	return fileExt == "FBX" || fileExt == "fbx";
+}
+
+/// \brief Check for archive extensions (.zip is read, .7z is reported)
+static bool isArchiveFile(const std::string& file)
+{
+	const size_t ext = file.find_last_of('.');
+	if (ext == std::string::npos) {
+		return false;
+	}
+	const std::string fileExt = file.substr(ext + 1);
+	return fileExt == "zip" || fileExt == "ZIP" ||
+		fileExt == "7z" || fileExt == "7Z";
+}
+
+/// \brief Add every fbx entry of a zip archive
+static void gatherArchiveFiles(const std::string& archive,
+							   std::vector<InputFbx>& out)
+{
+	const std::string ext = archive.substr(archive.find_last_of('.') + 1);
+	if (ext == "7z" || ext == "7Z") {
+		printf("%s: 7z archives are not supported (repack as .zip)\n",
+			   archive.c_str());
+		return;
+	}
+	ZipArchiveFBX zip;
+	if (!zip.open(archive.c_str())) {
+		return;
+	}
+	for (auto& entry : zip.entries()) {
+		if (isFbxFile(entry.name)) {
+			InputFbx input;
+			input.file = archive;
+			input.entry = entry.name;
+			out.push_back(input);
+		}
+	}
+}
+
+/// \brief Map input file or decompress archive entry into stream (buffer
+/// holds the decompressed entry)
+/// \param archives archives opened by the calling worker (each is opened and
+/// its central directory read once, then reused for its other entries)
+static bool loadInput(const InputFbx& input,
+					  std::unordered_map<std::string, ZipArchiveFBX>& archives,
+					  MemStreamFBX& stream, dd_array<char>& buffer)
+{
+	if (input.entry.empty()) {
+		return stream.mapFile(input.file.c_str());
+	}
+	auto found = archives.find(input.file);
+	if (found == archives.end()) {
+		found = archives.emplace(std::piecewise_construct,
+								 std::forward_as_tuple(input.file),
+								 std::forward_as_tuple()).first;
+		found->second.open(input.file.c_str());
+	}
+	const ZipEntryFBX* entry = found->second.find(input.entry);
+	if (!entry || !found->second.extract(*entry, buffer) || !buffer.isValid()) {
+		return false;
+	}
+	stream.setBuffer(&buffer[0], buffer.size());
+	return true;
+}
 
-	return 0;
+/// \brief Path used to name exported assets. Archive entries export next to
+/// the archive
+static std::string outputPath(const InputFbx& input)
+{
+	if (input.entry.empty()) {
+		return input.file;
+	}
+	const size_t dir_end = input.file.find_last_of("/\\");
+	const size_t name_start = input.entry.find_last_of('/');
+	const std::string dir = (dir_end == std::string::npos) ? "" :
+		input.file.substr(0, dir_end + 1);
+	return dir + ((name_start == std::string::npos) ? input.entry :
+				  input.entry.substr(name_start + 1));
+}
+
+/// \brief Expand wildcard pattern to matching file paths
+static void globFiles(const std::string& pattern, std::vector<std::string>& out)
+{
+#ifdef _WIN32
+	std::string dir;
+	const size_t dir_end = pattern.find_last_of("/\\");
+	if (dir_end != std::string::npos) {
+		dir = pattern.substr(0, dir_end + 1);
+	}
+	_finddata_t data;
+	intptr_t handle = _findfirst(pattern.c_str(), &data);
+	if (handle == -1) {
+		return;
+	}
+	do {
+		if (!(data.attrib & _A_SUBDIR)) {
+			out.push_back(dir + data.name);
+		}
+	} while (_findnext(handle, &data) == 0);
+	_findclose(handle);
+#else
+	glob_t results;
+	if (glob(pattern.c_str(), GLOB_MARK, nullptr, &results) == 0) {
+		for (size_t i = 0; i < results.gl_pathc; i++) {
+			std::string file = results.gl_pathv[i];
+			if (!file.empty() && file.back() != '/') {
+				out.push_back(file);
+			}
+		}
+	}
+	globfree(&results);
+#endif // _WIN32
+}
+
+/// \brief Collect fbx files from a directory, wildcard pattern or manifest
+/// (one path per line, '#' comments). Zip archives add their fbx entries
+std::vector<InputFbx> gatherBatchFiles(const std::string& input)
+{
+	std::vector<InputFbx> files;
+	std::vector<std::string> found;
+	struct stat info;
+
+	if (input.find_first_of("*?") != std::string::npos) {
+		globFiles(input, found);
+	}
+	else if (stat(input.c_str(), &info) == 0 &&
+			 (info.st_mode & S_IFMT) == S_IFDIR) {
+		std::string dir = input;
+		if (dir.back() != '/' && dir.back() != '\\') {
+			dir += '/';
+		}
+		globFiles(dir + "*", found);
+	}
+	else {
+		std::ifstream manifest(input);
+		std::string line;
+		while (std::getline(manifest, line)) {
+			// trim whitespace
+			const size_t first = line.find_first_not_of(" \t\r");
+			const size_t last = line.find_last_not_of(" \t\r");
+			if (first == std::string::npos || line[first] == '#') {
+				continue;
+			}
+			found.push_back(line.substr(first, last - first + 1));
+		}
+	}
+
+	for (auto& file : found) {
+		if (isFbxFile(file)) {
+			InputFbx fbx;
+			fbx.file = file;
+			files.push_back(fbx);
+		}
+		else if (isArchiveFile(file)) {
+			gatherArchiveFiles(file, files);
+		}
+	}
+	return files;
+}
+
+/// \brief Convert files on a bounded pool of worker threads (each thread
+/// owns one FbxManager) and report per-file and total throughput
+void runBatch(const std::vector<InputFbx>& files, const ConvertArgs& args,
+			  unsigned num_jobs)
+{
+	if (num_jobs == 0) {
+		num_jobs = std::thread::hardware_concurrency();
+		num_jobs = (num_jobs == 0) ? 1 : num_jobs;
+	}
+	num_jobs = std::min(num_jobs, (unsigned)files.size());
+	printf("Batch: %lu file(s) on %u worker(s)\n", files.size(), num_jobs);
+
+	std::vector<ConvertResult> results(files.size());
+	std::atomic<size_t> next_file(0);
+	std::mutex sdk_mutex;
+	auto batch_start = std::chrono::high_resolution_clock::now();
+
+	auto worker = [&]() {
+		FbxManager* sdkManager = nullptr;
+		{
+			// FbxManager creation touches global SDK state
+			std::lock_guard<std::mutex> lock(sdk_mutex);
+			sdkManager = FbxManager::Create();
+			setupImportProfile(sdkManager, args.flags);
+		}
+
+		// files are claimed only when the worker is free, so a slow file never
+		// holds back queued work. The next unclaimed file is only prefetched
+		// into the page cache so its read overlaps this conversion
+		MemStreamFBX stream;
+		dd_array<char> buffer;
+		std::unordered_map<std::string, ZipArchiveFBX> archives;
+		for (size_t idx = next_file.fetch_add(1); idx < files.size();
+			 idx = next_file.fetch_add(1)) {
+			ConvertResult& res = results[idx];
+			res.file = files[idx].entry.empty() ? files[idx].file :
+				files[idx].file + ":" + files[idx].entry;
+			auto start = std::chrono::high_resolution_clock::now();
+			if (loadInput(files[idx], archives, stream, buffer)) {
+				const size_t ahead = next_file.load();
+				if (ahead < files.size() && files[ahead].entry.empty()) {
+					MemStreamFBX::prefetchFile(files[ahead].file.c_str());
+				}
+				res.size_mb = (double)stream.size() / (1024.0 * 1024.0);
+				res.success = convertFbx(sdkManager, outputPath(files[idx]), args,
+										 &stream, &res.import_ms);
+			}
+			else {
+				printf("Could not load %s\n", res.file.c_str());
+			}
+			auto end = std::chrono::high_resolution_clock::now();
+			res.time_ms =
+				std::chrono::duration<double, std::milli>(end - start).count();
+
+			stream.release();
+			buffer.resize(0);
+		}
+
+		std::lock_guard<std::mutex> lock(sdk_mutex);
+		sdkManager->Destroy();
+	};
+
+	std::vector<std::thread> workers;
+	for (unsigned i = 0; i < num_jobs; i++) {
+		workers.emplace_back(worker);
+	}
+	for (auto& thread : workers) {
+		thread.join();
+	}
+
+	auto batch_end = std::chrono::high_resolution_clock::now();
+	const double total_s =
+		std::chrono::duration<double>(batch_end - batch_start).count();
+
+	printf("\n\n-----\nBatch\n-----\n\n");
+	size_t num_ok = 0;
+	double total_mb = 0.0;
+	double total_import_ms = 0.0;
+	for (auto& res : results) {
+		printf("%s %-48s %9.3f MB %10.3f ms (import %10.3f ms)\n",
+			   res.success ? "[ok]  " : "[fail]", res.file.c_str(), res.size_mb,
+			   res.time_ms, res.import_ms);
+		num_ok += res.success ? 1 : 0;
+		total_mb += res.size_mb;
+		total_import_ms += res.import_ms;
+	}
+	printf("\n%lu/%lu converted in %.3f s (%.3f files/s, %.3f MB/s)\n",
+		   num_ok, results.size(), total_s,
+		   (double)results.size() / total_s, total_mb / total_s);
+	printf("Import profile: %s\n\t%.3f ms total import, peak RSS %.1f MB\n",
+		   setupImportProfile(nullptr, args.flags).c_str(), total_import_ms,
+		   peakRssMB());
 }
 
 FbxNode *FindAttribute(FbxNode * _node, const FbxNodeAttribute::EType type)